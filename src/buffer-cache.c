@@ -0,0 +1,248 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/filesystem/buffer-cache.h"
+#include "header/stdlib/string.h"
+
+/**
+ * Buffer cache states, entries are indexed by hash bucket (cluster_number % bucket count)
+ * and ordered by doubly linked LRU list
+ * 
+ * @param entry       All cache entries
+ * @param hash_head   First entry index for every hash bucket
+ * @param lru_head    Most recently used entry index
+ * @param lru_tail    Least recently used entry index, will be evicted first
+ * @param initialized Lazy initialization flag
+ * @param dirty_count Entry count with non-zero dirty_block_mask
+ * @param tick        Timer tick since last write-back, saturate at BUFFER_CACHE_WRITEBACK_INTERVAL
+ * @param statistic   Cache counters
+ */
+static struct {
+    struct BufferCacheEntry     entry[BUFFER_CACHE_ENTRY_COUNT];
+    int16_t                     hash_head[BUFFER_CACHE_HASH_BUCKET_COUNT];
+    int16_t                     lru_head;
+    int16_t                     lru_tail;
+    bool                        initialized;
+    uint32_t                    dirty_count;
+    uint32_t                    tick;
+    struct BufferCacheStatistic statistic;
+} buffer_cache_state = {
+    .initialized = false,
+};
+
+#define BUFFER_CACHE_FULL_DIRTY_MASK ((1 << CLUSTER_BLOCK_COUNT) - 1)
+
+
+
+// -- Internal helper --
+static void buffer_cache_initialize(void) {
+    for (int16_t i = 0; i < BUFFER_CACHE_HASH_BUCKET_COUNT; i++)
+        buffer_cache_state.hash_head[i] = BUFFER_CACHE_INVALID_INDEX;
+    for (int16_t i = 0; i < BUFFER_CACHE_ENTRY_COUNT; i++) {
+        struct BufferCacheEntry *entry = &buffer_cache_state.entry[i];
+        entry->valid            = false;
+        entry->dirty_block_mask = 0;
+        entry->hash_next        = BUFFER_CACHE_INVALID_INDEX;
+        entry->lru_prev         = i - 1;
+        entry->lru_next         = (i == BUFFER_CACHE_ENTRY_COUNT - 1) ? BUFFER_CACHE_INVALID_INDEX : i + 1;
+    }
+    buffer_cache_state.lru_head    = 0;
+    buffer_cache_state.lru_tail    = BUFFER_CACHE_ENTRY_COUNT - 1;
+    buffer_cache_state.initialized = true;
+}
+
+static inline uint32_t buffer_cache_hash(uint32_t cluster_number) {
+    return cluster_number % BUFFER_CACHE_HASH_BUCKET_COUNT;
+}
+
+static int16_t buffer_cache_lookup(uint32_t cluster_number) {
+    int16_t index = buffer_cache_state.hash_head[buffer_cache_hash(cluster_number)];
+    while (index != BUFFER_CACHE_INVALID_INDEX && buffer_cache_state.entry[index].cluster_number != cluster_number)
+        index = buffer_cache_state.entry[index].hash_next;
+    return index;
+}
+
+static void buffer_cache_hash_remove(int16_t index) {
+    int16_t *iterator = &buffer_cache_state.hash_head[buffer_cache_hash(buffer_cache_state.entry[index].cluster_number)];
+    while (*iterator != index)
+        iterator = &buffer_cache_state.entry[*iterator].hash_next;
+    *iterator = buffer_cache_state.entry[index].hash_next;
+}
+
+static void buffer_cache_hash_insert(int16_t index) {
+    uint32_t bucket = buffer_cache_hash(buffer_cache_state.entry[index].cluster_number);
+    buffer_cache_state.entry[index].hash_next = buffer_cache_state.hash_head[bucket];
+    buffer_cache_state.hash_head[bucket]      = index;
+}
+
+// Move entry to front of LRU list
+static void buffer_cache_lru_touch(int16_t index) {
+    struct BufferCacheEntry *entry = &buffer_cache_state.entry[index];
+    if (buffer_cache_state.lru_head == index)
+        return;
+
+    // Unlink
+    buffer_cache_state.entry[entry->lru_prev].lru_next = entry->lru_next;
+    if (entry->lru_next != BUFFER_CACHE_INVALID_INDEX)
+        buffer_cache_state.entry[entry->lru_next].lru_prev = entry->lru_prev;
+    else
+        buffer_cache_state.lru_tail = entry->lru_prev;
+
+    // Push front
+    entry->lru_prev = BUFFER_CACHE_INVALID_INDEX;
+    entry->lru_next = buffer_cache_state.lru_head;
+    buffer_cache_state.entry[buffer_cache_state.lru_head].lru_prev = index;
+    buffer_cache_state.lru_head = index;
+}
+
+// Write contiguous runs of dirty blocks into disk
+static void buffer_cache_writeback(int16_t index) {
+    struct BufferCacheEntry *entry = &buffer_cache_state.entry[index];
+    if (entry->dirty_block_mask == 0)
+        return;
+
+    uint32_t lba = cluster_to_lba(entry->cluster_number);
+    for (uint32_t block = 0; block < CLUSTER_BLOCK_COUNT; block++) {
+        if (!(entry->dirty_block_mask & (1 << block)))
+            continue;
+        uint32_t run_length = 1;
+        while (block + run_length < CLUSTER_BLOCK_COUNT && (entry->dirty_block_mask & (1 << (block + run_length))))
+            run_length++;
+        write_blocks(entry->data.buf + BLOCK_SIZE*block, lba + block, run_length);
+        block += run_length - 1;
+    }
+    entry->dirty_block_mask = 0;
+    buffer_cache_state.dirty_count--;
+    buffer_cache_state.statistic.writeback++;
+}
+
+// Get entry index holding cluster_number, evict LRU entry on miss. If load is false, content is left undefined
+static int16_t buffer_cache_acquire(uint32_t cluster_number, bool load) {
+    if (!buffer_cache_state.initialized)
+        buffer_cache_initialize();
+
+    int16_t index = buffer_cache_lookup(cluster_number);
+    if (index != BUFFER_CACHE_INVALID_INDEX) {
+        buffer_cache_state.statistic.hit++;
+        buffer_cache_lru_touch(index);
+        return index;
+    }
+
+    // Miss, reuse least recently used entry
+    index = buffer_cache_state.lru_tail;
+    struct BufferCacheEntry *entry = &buffer_cache_state.entry[index];
+    if (entry->valid) {
+        buffer_cache_state.statistic.eviction++;
+        buffer_cache_writeback(index);
+        buffer_cache_hash_remove(index);
+    }
+    entry->cluster_number = cluster_number;
+    entry->valid          = true;
+    buffer_cache_hash_insert(index);
+    buffer_cache_lru_touch(index);
+
+    if (load) {
+        buffer_cache_state.statistic.miss++;
+        read_blocks(entry->data.buf, cluster_to_lba(cluster_number), CLUSTER_BLOCK_COUNT);
+    }
+    return index;
+}
+
+static void buffer_cache_set_dirty(int16_t index, uint8_t dirty_block_mask) {
+    struct BufferCacheEntry *entry = &buffer_cache_state.entry[index];
+    if (entry->dirty_block_mask == 0 && dirty_block_mask != 0)
+        buffer_cache_state.dirty_count++;
+    entry->dirty_block_mask |= dirty_block_mask;
+}
+
+
+
+// -- Buffer cache interfaces --
+void buffer_cache_read(void *ptr, uint32_t cluster_number) {
+    int16_t index = buffer_cache_acquire(cluster_number, true);
+    memcpy(ptr, buffer_cache_state.entry[index].data.buf, CLUSTER_SIZE);
+}
+
+void buffer_cache_write(const void *ptr, uint32_t cluster_number) {
+    // Whole cluster is overwritten, no need to load old content
+    int16_t index = buffer_cache_acquire(cluster_number, false);
+    memcpy(buffer_cache_state.entry[index].data.buf, ptr, CLUSTER_SIZE);
+    buffer_cache_set_dirty(index, BUFFER_CACHE_FULL_DIRTY_MASK);
+}
+
+void* buffer_cache_get(uint32_t cluster_number) {
+    int16_t index = buffer_cache_acquire(cluster_number, true);
+    return buffer_cache_state.entry[index].data.buf;
+}
+
+void buffer_cache_mark_dirty(uint32_t cluster_number, uint32_t offset, uint32_t size) {
+    int16_t index = buffer_cache_lookup(cluster_number);
+    if (index == BUFFER_CACHE_INVALID_INDEX || size == 0)
+        return;
+
+    uint32_t first_block = offset / BLOCK_SIZE;
+    uint32_t last_block  = (offset + size - 1) / BLOCK_SIZE;
+    uint8_t  mask        = 0;
+    for (uint32_t block = first_block; block <= last_block && block < CLUSTER_BLOCK_COUNT; block++)
+        mask |= 1 << block;
+    buffer_cache_set_dirty(index, mask);
+}
+
+void buffer_cache_overlay_dirty(void *ptr, uint32_t cluster_number) {
+    if (!buffer_cache_state.initialized)
+        return;
+    int16_t index = buffer_cache_lookup(cluster_number);
+    if (index != BUFFER_CACHE_INVALID_INDEX && buffer_cache_state.entry[index].dirty_block_mask != 0)
+        memcpy(ptr, buffer_cache_state.entry[index].data.buf, CLUSTER_SIZE);
+}
+
+void buffer_cache_refresh(const void *ptr, uint32_t cluster_number) {
+    if (!buffer_cache_state.initialized)
+        return;
+    int16_t index = buffer_cache_lookup(cluster_number);
+    if (index == BUFFER_CACHE_INVALID_INDEX)
+        return;
+
+    struct BufferCacheEntry *entry = &buffer_cache_state.entry[index];
+    memcpy(entry->data.buf, ptr, CLUSTER_SIZE);
+    if (entry->dirty_block_mask != 0) {
+        entry->dirty_block_mask = 0;
+        buffer_cache_state.dirty_count--;
+    }
+}
+
+void buffer_cache_sync(void) {
+    buffer_cache_state.tick = 0;
+    if (!buffer_cache_state.initialized)
+        return;
+    for (int16_t i = 0; i < BUFFER_CACHE_ENTRY_COUNT && buffer_cache_state.dirty_count > 0; i++)
+        buffer_cache_writeback(i);
+}
+
+void buffer_cache_tick(uint32_t tick) {
+    if (tick >= BUFFER_CACHE_WRITEBACK_INTERVAL - buffer_cache_state.tick)
+        buffer_cache_state.tick = BUFFER_CACHE_WRITEBACK_INTERVAL;
+    else
+        buffer_cache_state.tick += tick;
+}
+
+bool buffer_cache_writeback_due(void) {
+    if (buffer_cache_state.tick < BUFFER_CACHE_WRITEBACK_INTERVAL)
+        return false;
+    if (buffer_cache_state.dirty_count > 0)
+        return true;
+    buffer_cache_state.tick = 0;
+    return false;
+}
+
+uint32_t buffer_cache_writeback_next_tick(void) {
+    if (buffer_cache_state.dirty_count == 0)
+        return BUFFER_CACHE_NO_WRITEBACK;
+    if (buffer_cache_state.tick >= BUFFER_CACHE_WRITEBACK_INTERVAL)
+        return 0;
+    return BUFFER_CACHE_WRITEBACK_INTERVAL - buffer_cache_state.tick;
+}
+
+struct BufferCacheStatistic buffer_cache_get_statistic(void) {
+    return buffer_cache_state.statistic;
+}
@@ -4,6 +4,8 @@
 
 #include "header/driver/cmos.h"
 #include "header/cpu/portio.h"
+#include "header/cpu/interrupt.h"
+#include "header/cpu/clocksource.h"
 
 #define CMOS_COMMAND_PIO 0x70
 #define CMOS_DATA_PIO    0x71
@@ -15,17 +17,26 @@
 
 static struct CMOSTimeRTC cached_cmos_value = {0};
 
+/**
+ * RTC update states, sub-second is interpolated from timer tick since last update-ended interrupt
+ * 
+ * @param update_tick  Timer clock tick when cached value was last updated
+ * @param update_count Update-ended interrupt received since boot, one per second
+ */
+static struct {
+    uint32_t update_tick;
+    uint32_t update_count;
+} cmos_state = {
+    .update_tick  = 0,
+    .update_count = 0,
+};
+
 #define CMOS_STATUS_REGISTER_B                    0xB
 #define CMOS_STATUS_REGISTER_B_24_HR_MODE         0x2
 #define CMOS_STATUS_REGISTER_B_BINARY_ACCESS_MODE 0x4
-static void cmos_initialize() {
-    out(CMOS_COMMAND_PIO, CMOS_STATUS_REGISTER_B);
-    // Get current value of register B then set the flags
-    register uint8_t register_b_value = in(CMOS_DATA_PIO); 
-    register_b_value |= CMOS_STATUS_REGISTER_B_24_HR_MODE;
-    register_b_value |= CMOS_STATUS_REGISTER_B_BINARY_ACCESS_MODE;
-    out(CMOS_DATA_PIO, register_b_value);
-}
+#define CMOS_STATUS_REGISTER_B_UPDATE_ENDED_INT   0x10
+#define CMOS_STATUS_REGISTER_C                    0xC
+#define CMOS_STATUS_REGISTER_C_UPDATE_ENDED       0x10
 
 #define CMOS_STATUS_REGISTER_A 0xA
 static bool cmos_check_update() {
@@ -46,10 +57,7 @@ static uint8_t cmos_get_register(uint8_t cmos_register) {
 #define CMOS_MONTH_REGISTER   0x08
 #define CMOS_YEAR_REGISTER    0x09
 #define CMOS_CENTURY_REGISTER 0x32
-void cmos_fetch_update() {
-    cmos_initialize();
-
-    while (cmos_check_update());
+static void cmos_read_time(void) {
     cached_cmos_value.second  = cmos_get_register(CMOS_SECOND_REGISTER);
     cached_cmos_value.minute  = cmos_get_register(CMOS_MINUTE_REGISTER);
     cached_cmos_value.hour    = (cmos_get_register(CMOS_HOUR_REGISTER) + CMOS_TIMEZONE) % 24;
@@ -58,8 +66,71 @@ void cmos_fetch_update() {
     cached_cmos_value.month   = cmos_get_register(CMOS_MONTH_REGISTER);
     cached_cmos_value.year    = cmos_get_register(CMOS_YEAR_REGISTER);
     cached_cmos_value.century = cmos_get_register(CMOS_CENTURY_REGISTER);
+    cmos_state.update_tick    = timer_get_clock_tick();
+}
+
+// Millisecond since last update, RTC update is the authority so interpolation never pass next second
+static uint16_t cmos_interpolated_millisecond(void) {
+    uint32_t elapsed_tick = timer_get_clock_tick() - cmos_state.update_tick;
+    return elapsed_tick < 1000 ? elapsed_tick : 999;
+}
+
+// Day since 1970-01-01 of proleptic Gregorian date, year start in March so leap day is last day of year
+static uint32_t cmos_days_from_civil(uint32_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    uint32_t era         = year / 400;
+    uint32_t year_of_era = year - era * 400;
+    uint32_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t day_of_era  = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+void cmos_initialize() {
+    out(CMOS_COMMAND_PIO, CMOS_STATUS_REGISTER_B);
+    // Get current value of register B then set the flags
+    register uint8_t register_b_value = in(CMOS_DATA_PIO); 
+    register_b_value |= CMOS_STATUS_REGISTER_B_24_HR_MODE;
+    register_b_value |= CMOS_STATUS_REGISTER_B_BINARY_ACCESS_MODE;
+    register_b_value |= CMOS_STATUS_REGISTER_B_UPDATE_ENDED_INT;
+    out(CMOS_COMMAND_PIO, CMOS_STATUS_REGISTER_B);
+    out(CMOS_DATA_PIO, register_b_value);
+
+    // Pending flag in register C would block next IRQ 8 until read
+    cmos_get_register(CMOS_STATUS_REGISTER_C);
+    cmos_fetch_update();
+    activate_cmos_interrupt();
+}
+
+void cmos_fetch_update() {
+    while (cmos_check_update());
+    cmos_read_time();
+}
+
+void cmos_isr(void) {
+    // Time register is stable for almost a second after update ended, no need to poll update-in-progress
+    if (cmos_get_register(CMOS_STATUS_REGISTER_C) & CMOS_STATUS_REGISTER_C_UPDATE_ENDED) {
+        cmos_read_time();
+        cmos_state.update_count++;
+        clocksource_sync_wall_clock(cmos_get_epoch_second(cached_cmos_value));
+    }
+    pic_ack(IRQ_CMOS);
 }
 
 struct CMOSTimeRTC cmos_get_current_driver_data() {
-    return cached_cmos_value;
+    struct CMOSTimeRTC time = cached_cmos_value;
+    time.millisecond        = cmos_interpolated_millisecond();
+    return time;
+}
+
+uint32_t cmos_get_monotonic_ms(void) {
+    return cmos_state.update_count * 1000 + cmos_interpolated_millisecond();
+}
+
+uint32_t cmos_get_epoch_second(struct CMOSTimeRTC time) {
+    // Only cached hour is shifted into local time, date is still raw UTC from RTC.
+    // Century register is not guaranteed to exist
+    uint32_t utc_hour = (time.hour + 24 - CMOS_TIMEZONE) % 24;
+    uint32_t century  = 19 <= time.century && time.century <= 21 ? time.century : 20;
+    uint32_t day      = cmos_days_from_civil(century * 100 + time.year, time.month, time.day);
+    return day * 86400 + utc_hour * 3600 + time.minute * 60 + time.second;
 }
@@ -0,0 +1,120 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/cpu/apic.h"
+#include "header/cpu/portio.h"
+#include "header/cpu/interrupt.h"
+#include "header/memory/paging.h"
+
+/**
+ * Local APIC states. Timer count down from armed count and stop at zero
+ *
+ * @param register_base  Virtual address of local APIC register page, NULL if unavailable
+ * @param count_per_tick Timer count in single timer tick, 0 if timer is not calibrated
+ * @param armed_count    Timer count when last collected, elapsed count is the decrease since then
+ * @param elapsed_count  Collected count not yet consumed as whole tick
+ */
+static struct {
+    volatile uint8_t *register_base;
+    uint32_t         count_per_tick;
+    uint32_t         armed_count;
+    uint32_t         elapsed_count;
+} apic_state = {
+    .register_base  = NULL,
+    .count_per_tick = 0,
+    .armed_count    = 0,
+    .elapsed_count  = 0,
+};
+
+
+
+// -- Internal helper --
+static uint32_t apic_read(uint32_t offset) {
+    return *(volatile uint32_t*) (apic_state.register_base + offset);
+}
+
+static void apic_write(uint32_t offset, uint32_t value) {
+    *(volatile uint32_t*) (apic_state.register_base + offset) = value;
+}
+
+// Add timer count decrease since last collection into elapsed count
+static void apic_timer_collect(void) {
+    uint32_t current_count     = apic_read(APIC_REGISTER_TIMER_CURRENT);
+    apic_state.elapsed_count  += apic_state.armed_count - current_count;
+    apic_state.armed_count     = current_count;
+}
+
+// Count local APIC timer decrease over APIC_CALIBRATION_TICK measured with PIT channel 2
+static uint32_t apic_timer_calibrate(void) {
+    // Both counter start back to back
+    apic_write(APIC_REGISTER_TIMER_DIVIDE, APIC_TIMER_DIVIDE_16);
+    apic_write(APIC_REGISTER_LVT_TIMER, APIC_LVT_MASKED | APIC_TIMER_VECTOR);
+    pit_oneshot_start(APIC_CALIBRATION_TICK);
+    apic_write(APIC_REGISTER_TIMER_INITIAL, 0xFFFFFFFF);
+    while (!pit_oneshot_done())
+        if (apic_read(APIC_REGISTER_TIMER_CURRENT) == 0)
+            return 0;
+    uint32_t elapsed_count = 0xFFFFFFFF - apic_read(APIC_REGISTER_TIMER_CURRENT);
+
+    apic_write(APIC_REGISTER_TIMER_INITIAL, 0);
+    return elapsed_count / APIC_CALIBRATION_TICK;
+}
+
+
+
+// -- Public interfaces --
+bool apic_initialize(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEATURE_EDX_APIC))
+        return false;
+
+    uint32_t apic_base = (uint32_t) read_msr(MSR_APIC_BASE);
+    apic_state.register_base = paging_map_kernel_mmio(apic_base & MSR_APIC_BASE_ADDRESS_MASK);
+    if (apic_state.register_base == NULL)
+        return false;
+    write_msr(MSR_APIC_BASE, apic_base | MSR_APIC_BASE_ENABLE);
+
+    // Virtual wire mode, PIC interrupt keep arriving through LINT0 after software enable
+    apic_write(APIC_REGISTER_TASK_PRIORITY, 0);
+    apic_write(APIC_REGISTER_LVT_LINT0, APIC_LVT_DELIVERY_EXTINT);
+    apic_write(APIC_REGISTER_LVT_LINT1, APIC_LVT_DELIVERY_NMI);
+    apic_write(APIC_REGISTER_SPURIOUS, APIC_SPURIOUS_ENABLE | APIC_SPURIOUS_VECTOR);
+
+    apic_state.count_per_tick = apic_timer_calibrate();
+    if (apic_state.count_per_tick == 0)
+        return false;
+    apic_write(APIC_REGISTER_LVT_TIMER, APIC_TIMER_VECTOR);
+    return true;
+}
+
+bool apic_timer_available(void) {
+    return apic_state.count_per_tick != 0;
+}
+
+void apic_timer_arm(uint32_t tick) {
+    apic_timer_collect();
+    uint32_t due_count = tick > APIC_TIMER_MAX_COUNT / apic_state.count_per_tick
+        ? APIC_TIMER_MAX_COUNT
+        : tick * apic_state.count_per_tick;
+    // Initial count 0 stop the timer, due timer use smallest count instead
+    uint32_t count = due_count > apic_state.elapsed_count ? due_count - apic_state.elapsed_count : 1;
+    apic_state.armed_count = count;
+    apic_write(APIC_REGISTER_TIMER_INITIAL, count);
+}
+
+uint32_t apic_timer_elapsed_tick(void) {
+    apic_timer_collect();
+    uint32_t tick             = apic_state.elapsed_count / apic_state.count_per_tick;
+    apic_state.elapsed_count -= tick * apic_state.count_per_tick;
+    return tick;
+}
+
+uint32_t apic_timer_pending_tick(void) {
+    apic_timer_collect();
+    return apic_state.elapsed_count / apic_state.count_per_tick;
+}
+
+void apic_eoi(void) {
+    apic_write(APIC_REGISTER_EOI, 0);
+}
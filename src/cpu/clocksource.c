@@ -0,0 +1,134 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/cpu/clocksource.h"
+#include "header/cpu/interrupt.h"
+#include "header/cpu/portio.h"
+#include "header/driver/cmos.h"
+
+/**
+ * Clocksource states. Monotonic clock start at zero on initialization, wall clock is offset from it
+ * and re-anchored on every RTC second edge
+ *
+ * @param tsc_available     TSC is calibrated and used, timer tick is used otherwise
+ * @param mult              Nanosecond per TSC cycle scaled by 2^CLOCKSOURCE_SHIFT
+ * @param tsc_base          TSC value at monotonic zero
+ * @param tick_base         Timer tick at monotonic zero, for clock without TSC
+ * @param wall_second       UTC second since epoch at wall_monotonic_ns
+ * @param wall_monotonic_ns Monotonic time when wall_second is sampled
+ * @param wall_hold_ns      Wall clock was this far ahead of RTC at last anchor, it stand still until RTC catch up
+ */
+static struct {
+    bool     tsc_available;
+    uint32_t mult;
+    uint64_t tsc_base;
+    uint32_t tick_base;
+    uint32_t wall_second;
+    uint64_t wall_monotonic_ns;
+    uint32_t wall_hold_ns;
+} clocksource_state = {
+    .tsc_available = false,
+    .mult          = 0,
+    .wall_hold_ns  = 0,
+};
+
+
+
+// -- Internal helper --
+static uint64_t rdtsc(void) {
+    uint32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t) high << 32) | low;
+}
+
+// 64 by 32 bit division with single divl, caller guarantee quotient fit 32 bit (dividend >> 32 < divisor)
+static uint32_t clocksource_divide(uint64_t dividend, uint32_t divisor, uint32_t *remainder) {
+    uint32_t quotient, rest;
+    __asm__("divl %4"
+        : "=a"(quotient), "=d"(rest)
+        : "a"((uint32_t) dividend), "d"((uint32_t) (dividend >> 32)), "rm"(divisor)
+    );
+    if (remainder != NULL)
+        *remainder = rest;
+    return quotient;
+}
+
+// Nanosecond per cycle scaled by 2^CLOCKSOURCE_SHIFT, 0 if TSC is too slow for 32-bit mult
+static uint32_t clocksource_calibrate_tsc(void) {
+    pit_oneshot_start(CLOCKSOURCE_CALIBRATION_MS);
+    uint64_t start = rdtsc();
+    while (!pit_oneshot_done());
+    uint64_t cycle = rdtsc() - start;
+
+    uint64_t scaled_window_ns = (uint64_t) CLOCKSOURCE_CALIBRATION_MS * 1000000u << CLOCKSOURCE_SHIFT;
+    if ((cycle >> 32) != 0 || (scaled_window_ns >> 32) >= cycle)
+        return 0;
+    return clocksource_divide(scaled_window_ns, (uint32_t) cycle, NULL);
+}
+
+static void clocksource_split(uint64_t ns, struct ClockTimespec *time) {
+    time->second = clocksource_divide(ns, CLOCKSOURCE_NANOSECOND_PER_SEC, &time->nanosecond);
+}
+
+// Nanosecond since wall clock anchor, never below hold so re-anchoring never step wall clock backward
+static uint64_t clocksource_wall_elapsed_ns(uint64_t monotonic_ns) {
+    uint64_t elapsed_ns = monotonic_ns - clocksource_state.wall_monotonic_ns;
+    return elapsed_ns > clocksource_state.wall_hold_ns ? elapsed_ns : clocksource_state.wall_hold_ns;
+}
+
+
+
+// -- Public interfaces --
+void clocksource_initialize(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (edx & CPUID_FEATURE_EDX_TSC)
+        clocksource_state.mult = clocksource_calibrate_tsc();
+    clocksource_state.tsc_available = clocksource_state.mult != 0;
+    clocksource_state.tsc_base      = rdtsc();
+    clocksource_state.tick_base     = timer_get_clock_tick();
+
+    // Coarse wall clock until first RTC second edge, edge seen during calibration used stale base
+    clocksource_state.wall_second       = cmos_get_epoch_second(cmos_get_current_driver_data());
+    clocksource_state.wall_monotonic_ns = 0;
+    clocksource_state.wall_hold_ns      = 0;
+}
+
+uint64_t clocksource_get_monotonic_ns(void) {
+    if (!clocksource_state.tsc_available)
+        return (uint64_t) (timer_get_clock_tick() - clocksource_state.tick_base) * 1000000u;
+
+    // (cycle * mult) >> shift, split into 32-bit half so product never overflow
+    uint64_t cycle = rdtsc() - clocksource_state.tsc_base;
+    uint64_t high  = (uint64_t) (uint32_t) (cycle >> 32) * clocksource_state.mult;
+    uint64_t low   = (uint64_t) (uint32_t) cycle * clocksource_state.mult;
+    return (high << (32 - CLOCKSOURCE_SHIFT)) + (low >> CLOCKSOURCE_SHIFT);
+}
+
+void clocksource_sync_wall_clock(uint32_t epoch_second) {
+    // Calibration error accumulate between edge, clock ahead of RTC hold instead of stepping back.
+    // Difference of whole second or more is RTC being set, which is followed as is
+    uint64_t monotonic_ns = clocksource_get_monotonic_ns();
+    uint64_t wall_ns      = (uint64_t) clocksource_state.wall_second * CLOCKSOURCE_NANOSECOND_PER_SEC
+        + clocksource_wall_elapsed_ns(monotonic_ns);
+    uint64_t rtc_ns       = (uint64_t) epoch_second * CLOCKSOURCE_NANOSECOND_PER_SEC;
+    bool     is_ahead     = wall_ns > rtc_ns && wall_ns - rtc_ns < CLOCKSOURCE_NANOSECOND_PER_SEC;
+
+    clocksource_state.wall_second       = epoch_second;
+    clocksource_state.wall_monotonic_ns = monotonic_ns;
+    clocksource_state.wall_hold_ns      = is_ahead ? (uint32_t) (wall_ns - rtc_ns) : 0;
+}
+
+int8_t clocksource_get_time(uint32_t clock_id, struct ClockTimespec *time) {
+    uint64_t monotonic_ns = clocksource_get_monotonic_ns();
+    switch (clock_id) {
+        case CLOCK_MONOTONIC:
+            clocksource_split(monotonic_ns, time);
+            return CLOCKSOURCE_GET_TIME_SUCCESS;
+        case CLOCK_REALTIME:
+            clocksource_split(clocksource_wall_elapsed_ns(monotonic_ns), time);
+            time->second += clocksource_state.wall_second;
+            return CLOCKSOURCE_GET_TIME_SUCCESS;
+    }
+    return CLOCKSOURCE_GET_TIME_FAIL_ID;
+}
@@ -0,0 +1,146 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/cpu/fpu.h"
+#include "header/cpu/portio.h"
+#include "header/process/process.h"
+#include "header/memory/slab.h"
+#include "header/stdlib/string.h"
+
+/**
+ * Lazy FPU states. FPU register hold state of owner until other process use FPU
+ *
+ * @param available   CPU support FXSAVE and FPU is enabled
+ * @param owner       Process whose state is loaded in FPU register, NULL if none
+ * @param state_cache Slab cache of FPUState, created on first FPU use
+ */
+static struct {
+    bool                       available;
+    struct ProcessControlBlock *owner;
+    struct SlabCache           *state_cache;
+} fpu_state = {
+    .available   = false,
+    .owner       = NULL,
+    .state_cache = NULL,
+};
+
+
+
+// -- Internal helper --
+static void fpu_set_task_switched(bool value) {
+    uint32_t cr0;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0): /* <Empty> */);
+    if (value)
+        cr0 |= CPU_CR0_TASK_SWITCHED;
+    else
+        cr0 &= ~CPU_CR0_TASK_SWITCHED;
+    __asm__ volatile("mov %0, %%cr0" : /* <Empty> */ : "r"(cr0): "memory");
+}
+
+static struct FPUState* fpu_state_alloc(void) {
+    if (fpu_state.state_cache == NULL)
+        fpu_state.state_cache = slab_cache_create("fpu", sizeof(struct FPUState), FPU_STATE_ALIGN, NULL);
+    if (fpu_state.state_cache == NULL)
+        return NULL;
+    return slab_cache_alloc(fpu_state.state_cache);
+}
+
+static void fpu_save(struct FPUState *state) {
+    __asm__ volatile("fxsave %0" : "=m"(*state));
+}
+
+static void fpu_restore(struct FPUState *state) {
+    __asm__ volatile("fxrstor %0" : /* <Empty> */ : "m"(*state));
+}
+
+// Save FPU register into owner state, register is assumed accessible
+static void fpu_save_owner(void) {
+    if (fpu_state.owner != NULL)
+        fpu_save(fpu_state.owner->fpu_state);
+}
+
+
+
+// -- Public interfaces --
+void fpu_initialize(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEATURE_EDX_FXSR))
+        return;
+
+    // No emulation, WAIT also respect TS, x87 exception is reported natively
+    uint32_t cr0, cr4;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0): /* <Empty> */);
+    cr0 &= ~CPU_CR0_EMULATION;
+    cr0 |= CPU_CR0_MONITOR_COPROCESSOR | CPU_CR0_NUMERIC_ERROR | CPU_CR0_TASK_SWITCHED;
+    __asm__ volatile("mov %0, %%cr0" : /* <Empty> */ : "r"(cr0): "memory");
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4): /* <Empty> */);
+    cr4 |= CPU_CR4_OSFXSR | CPU_CR4_OSXMMEXCPT;
+    __asm__ volatile("mov %0, %%cr4" : /* <Empty> */ : "r"(cr4): "memory");
+    fpu_state.available = true;
+
+    if (edx & CPUID_FEATURE_EDX_SSE2)
+        string_enable_sse2(fpu_kernel_begin, fpu_kernel_end);
+}
+
+void fpu_kernel_begin(void) {
+    fpu_set_task_switched(false);
+    fpu_save_owner();
+    fpu_state.owner = NULL;
+}
+
+void fpu_kernel_end(void) {
+    fpu_set_task_switched(true);
+}
+
+void fpu_switch_process(struct ProcessControlBlock *pcb) {
+    if (fpu_state.available)
+        fpu_set_task_switched(pcb != fpu_state.owner);
+}
+
+bool fpu_handle_device_not_available(void) {
+    struct ProcessControlBlock *running_pcb = process_get_current_running_pcb_pointer();
+    if (!fpu_state.available || running_pcb == NULL)
+        return false;
+
+    fpu_set_task_switched(false);
+    if (running_pcb == fpu_state.owner)
+        return true;
+    bool first_use = running_pcb->fpu_state == NULL;
+    if (first_use && (running_pcb->fpu_state = fpu_state_alloc()) == NULL)
+        return false;
+
+    fpu_save_owner();
+    fpu_state.owner = running_pcb;
+    if (first_use) {
+        uint32_t mxcsr = FPU_MXCSR_DEFAULT;
+        __asm__ volatile("fninit; ldmxcsr %0" : /* <Empty> */ : "m"(mxcsr));
+    } else {
+        fpu_restore(running_pcb->fpu_state);
+    }
+    return true;
+}
+
+bool fpu_fork(struct ProcessControlBlock *parent, struct ProcessControlBlock *child) {
+    child->fpu_state = NULL;
+    if (parent->fpu_state == NULL)
+        return true;
+    if ((child->fpu_state = fpu_state_alloc()) == NULL)
+        return false;
+
+    // Live register of running parent is newer than its saved state
+    if (parent == fpu_state.owner) {
+        fpu_set_task_switched(false);
+        fpu_save(parent->fpu_state);
+    }
+    memcpy(child->fpu_state, parent->fpu_state, sizeof(struct FPUState));
+    return true;
+}
+
+void fpu_release(struct ProcessControlBlock *pcb) {
+    if (pcb == fpu_state.owner)
+        fpu_state.owner = NULL;
+    if (pcb->fpu_state != NULL)
+        slab_cache_free(fpu_state.state_cache, pcb->fpu_state);
+    pcb->fpu_state = NULL;
+}
@@ -1,5 +1,6 @@
 #include "header/cpu/idt.h"
 #include "header/cpu/gdt.h"
+#include "header/cpu/apic.h"
 
 static struct InterruptDescriptorTable interrupt_descriptor_table = {
     .table = {{0}},
@@ -12,7 +13,8 @@ struct IDTR _idt_idtr = {
 
 void initialize_idt(void) {
     for (uint8_t int_vector = 0; int_vector < ISR_STUB_TABLE_LIMIT; int_vector++) {
-        if (int_vector < 0x30)
+        // Local APIC vector is above syscall, user must not raise fake timer interrupt
+        if (int_vector < 0x30 || int_vector >= APIC_TIMER_VECTOR)
             set_interrupt_gate(int_vector, isr_stub_table[int_vector], GDT_KERNEL_CODE_SEGMENT_SELECTOR, 0x0);
         else
             set_interrupt_gate(int_vector, isr_stub_table[int_vector], GDT_KERNEL_CODE_SEGMENT_SELECTOR, 0x3);
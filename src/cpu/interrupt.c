@@ -1,12 +1,22 @@
 #include "header/cpu/interrupt.h"
 #include "header/cpu/portio.h"
 #include "header/cpu/gdt.h"
+#include "header/cpu/fpu.h"
+#include "header/cpu/apic.h"
+#include "header/cpu/clocksource.h"
 #include "header/driver/keyboard.h"
+#include "header/driver/disk.h"
 
 #include "header/filesystem/fat32.h"
+#include "header/filesystem/buffer-cache.h"
+#include "header/filesystem/file.h"
+#include "header/filesystem/image-cache.h"
 #include "header/text/textio.h"
 #include "header/process/scheduler.h"
 #include "header/memory/paging.h"
+#include "header/memory/frame-allocator.h"
+#include "header/memory/slab.h"
+#include "header/stdlib/string-benchmark.h"
 #include "header/kernel-entrypoint.h"
 #include "header/driver/cmos.h"
 
@@ -14,6 +24,23 @@ struct TSSEntry _interrupt_tss_entry = {
     .ss0  = GDT_KERNEL_DATA_SEGMENT_SELECTOR,
 };
 
+/**
+ * Timer states
+ *
+ * @param tickless        Local APIC one-shot timer is armed per event, PIT IRQ is left masked
+ * @param in_service      Timer interrupt is received but not yet acknowledged
+ * @param interrupt_count Timer interrupt received since boot
+ */
+static struct {
+    bool     tickless;
+    bool     in_service;
+    uint32_t interrupt_count;
+} timer_state = {
+    .tickless        = false,
+    .in_service      = false,
+    .interrupt_count = 0,
+};
+
 void set_tss_kernel_current_stack(void) {
     uint32_t stack_ptr;
     // Reading base stack frame instead esp
@@ -60,6 +87,16 @@ void activate_keyboard_interrupt(void) {
     out(PIC1_DATA, in(PIC1_DATA) & ~(1 << IRQ_KEYBOARD));
 }
 
+void activate_primary_ata_interrupt(void) {
+    out(PIC1_DATA, in(PIC1_DATA) & ~(1 << IRQ_CASCADE));
+    out(PIC2_DATA, in(PIC2_DATA) & ~(1 << (IRQ_PRIMARY_ATA - 8)));
+}
+
+void activate_cmos_interrupt(void) {
+    out(PIC1_DATA, in(PIC1_DATA) & ~(1 << IRQ_CASCADE));
+    out(PIC2_DATA, in(PIC2_DATA) & ~(1 << (IRQ_CMOS - 8)));
+}
+
 #define PIT_MAX_FREQUENCY   1193182
 #define PIT_TIMER_FREQUENCY 1000
 #define PIT_TIMER_COUNTER   (PIT_MAX_FREQUENCY / PIT_TIMER_FREQUENCY)
@@ -73,8 +110,32 @@ void activate_keyboard_interrupt(void) {
 
 #define PIT_CHANNEL_0_DATA_PIO 0x40
 
+// PIT channel 2 is gated by port 0x61 and its output is readable without interrupt
+#define PIT_CHANNEL_2_DATA_PIO        0x42
+#define PIT_CHANNEL_2_GATE_PIO        0x61
+#define PIT_CHANNEL_2_GATE            (1 << 0)
+#define PIT_CHANNEL_2_SPEAKER         (1 << 1)
+#define PIT_CHANNEL_2_OUTPUT          (1 << 5)
+// Channel 2, lobyte / hibyte access, mode 0 (interrupt on terminal count), binary
+#define PIT_CHANNEL_2_ONESHOT_COMMAND 0b10110000
+
+// int 0x30 & sysenter instruction length, blocking syscall rewind eip by this to be retried after wake up
+#define SYSCALL_INSTRUCTION_SIZE 2
+
+// SYSENTER target MSR, refer to Intel x86 Vol 3a: 5.8.7 Performing Fast Calls to System Procedures
+#define MSR_SYSENTER_CS          0x174
+#define MSR_SYSENTER_ESP         0x175
+#define MSR_SYSENTER_EIP         0x176
+#define CPUID_FEATURE_EDX_SEP    (1 << 11)
+
 void activate_timer_interrupt(void) {
     __asm__ volatile("cli");
+    if (apic_timer_available()) {
+        timer_state.tickless = true;
+        timer_arm_next_event();
+        return;
+    }
+
     // Setup how often PIT fire
     uint32_t pit_timer_counter_to_fire = PIT_TIMER_COUNTER;
     out(PIT_COMMAND_REGISTER_PIO, PIT_COMMAND_VALUE);
@@ -85,88 +146,376 @@ void activate_timer_interrupt(void) {
     out(PIC1_DATA, in(PIC1_DATA) & ~(1 << IRQ_TIMER));
 }
 
+void pit_oneshot_start(uint32_t ms) {
+    uint32_t pit_count = PIT_MAX_FREQUENCY / 1000 * ms;
+    uint8_t  gate      = in(PIT_CHANNEL_2_GATE_PIO) & ~(PIT_CHANNEL_2_GATE | PIT_CHANNEL_2_SPEAKER);
+    out(PIT_CHANNEL_2_GATE_PIO, gate);
+    out(PIT_COMMAND_REGISTER_PIO, PIT_CHANNEL_2_ONESHOT_COMMAND);
+    out(PIT_CHANNEL_2_DATA_PIO, (uint8_t) (pit_count & 0xFF));
+    out(PIT_CHANNEL_2_DATA_PIO, (uint8_t) ((pit_count >> 8) & 0xFF));
+
+    // Rising gate start the count
+    out(PIT_CHANNEL_2_GATE_PIO, gate | PIT_CHANNEL_2_GATE);
+}
+
+bool pit_oneshot_done(void) {
+    return in(PIT_CHANNEL_2_GATE_PIO) & PIT_CHANNEL_2_OUTPUT;
+}
+
+void timer_ack(void) {
+    // EOI without timer in service would acknowledge other IRQ instead
+    if (!timer_state.in_service)
+        return;
+    timer_state.in_service = false;
+    if (timer_state.tickless)
+        apic_eoi();
+    else
+        pic_ack(IRQ_TIMER);
+}
+
+// Timer tick is accounted into scheduler clock & write-back interval even when interrupted from kernel or idle
+static void timer_account_tick(uint32_t tick) {
+    scheduler_clock_tick(tick);
+    buffer_cache_tick(tick);
+}
+
+void timer_catch_up(void) {
+    if (timer_state.tickless)
+        timer_account_tick(apic_timer_elapsed_tick());
+}
+
+void timer_arm_next_event(void) {
+    if (!timer_state.tickless)
+        return;
+
+    // Write-back only happen on interrupt from running process, idle CPU is not woken for it
+    uint32_t next_tick      = scheduler_next_event_tick();
+    uint32_t writeback_tick = buffer_cache_writeback_next_tick();
+    if (scheduler_get_running_process() != NULL && writeback_tick < next_tick)
+        next_tick = writeback_tick;
+    apic_timer_arm(next_tick);
+}
+
+uint32_t timer_get_clock_tick(void) {
+    uint32_t clock_tick = scheduler_get_clock_tick();
+    if (timer_state.tickless)
+        clock_tick += apic_timer_pending_tick();
+    return clock_tick;
+}
+
+void activate_sysenter_syscall(void) {
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    if (!(edx & CPUID_FEATURE_EDX_SEP))
+        return;
+
+    // Kernel stack is shared with interrupt, kernel SS & user CS / SS is implied from consecutive GDT entry
+    write_msr(MSR_SYSENTER_CS, GDT_KERNEL_CODE_SEGMENT_SELECTOR);
+    write_msr(MSR_SYSENTER_ESP, _interrupt_tss_entry.esp0);
+    write_msr(MSR_SYSENTER_EIP, (uint32_t) sysenter_handler);
+}
+
+// Context of interrupted user process, resumed right after the interrupt
+static struct Context interrupt_frame_to_context(struct InterruptFrame *frame) {
+    return (struct Context) {
+        .cpu                         = frame->cpu,
+        .eflags                      = frame->int_stack.eflags,
+        .eip                         = frame->int_stack.eip,
+        .page_directory_virtual_addr = paging_get_current_page_directory_addr(),
+    };
+}
 
 void main_interrupt_handler(struct InterruptFrame frame) {
     switch (frame.int_number) {
-        case PIC1_OFFSET + IRQ_TIMER: {
-            cmos_fetch_update();
+        case PIC1_OFFSET + IRQ_TIMER:
+        case APIC_TIMER_VECTOR: {
+            // Periodic PIT interrupt every tick, one-shot local APIC timer may cover several tick or none
+            uint32_t tick = timer_state.tickless ? apic_timer_elapsed_tick() : 1;
+            timer_state.in_service = true;
+            timer_state.interrupt_count++;
+            timer_account_tick(tick);
             if (frame.int_stack.eip >= (uint32_t) &_linker_kernel_virtual_base) {
-                pic_ack(IRQ_TIMER);
+                timer_arm_next_event();
+                timer_ack();
                 return;
             }
-            struct Context ctx = {
-                .cpu                         = frame.cpu,
-                .eflags                      = frame.int_stack.eflags,
-                .eip                         = frame.int_stack.eip,
-                .page_directory_virtual_addr = paging_get_current_page_directory_addr(),
-            };
-            scheduler_save_context_to_current_running_pcb(ctx);
+
+            // Interrupted from user mode, no file system operation in progress
+            if (buffer_cache_writeback_due()) {
+                timer_ack(); // Disk IRQ cannot be serviced while timer IRQ is in service
+                buffer_cache_sync();
+            }
+
+            // Running process continue its quantum without context switch
+            if (!scheduler_tick(tick)) {
+                timer_arm_next_event();
+                timer_ack();
+                break;
+            }
+            scheduler_save_context_to_current_running_pcb(interrupt_frame_to_context(&frame));
             scheduler_switch_to_next_process();
             break;
         }
         case PIC1_OFFSET + IRQ_KEYBOARD:
             keyboard_isr();
             break;
+        case PIC1_OFFSET + IRQ_PRIMARY_ATA:
+            disk_isr();
+            break;
+        case PIC1_OFFSET + IRQ_CMOS:
+            cmos_isr();
+            break;
+        case 0x7: {
+            if (fpu_handle_device_not_available())
+                break;
+
+            // FPU unusable for running process, cannot continue the faulting instruction
+            struct ProcessControlBlock *faulting_pcb = process_get_current_running_pcb_pointer();
+            while (faulting_pcb == NULL)
+                __asm__ volatile("cli; hlt"); // FPU used outside process context, halt the kernel
+            process_destroy(faulting_pcb->metadata.pid);
+            scheduler_switch_to_next_process();
+            break;
+        }
+        case 0xE: {
+            if (process_handle_page_fault(paging_get_page_fault_addr(), frame.int_stack.error_code))
+                break;
+
+            // Unserviceable fault, running process cannot continue and never scheduled again
+            struct ProcessControlBlock *faulting_pcb = process_get_current_running_pcb_pointer();
+            while (faulting_pcb == NULL)
+                __asm__ volatile("cli; hlt"); // Fault outside process context, halt the kernel
+            process_destroy(faulting_pcb->metadata.pid);
+            scheduler_switch_to_next_process();
+            break;
+        }
         case 0x30:
-            syscall(frame);
+            syscall(&frame);
             break;
     }
 }
 
-void syscall(struct InterruptFrame frame) {
-    switch (frame.cpu.general.eax) {
-        case 0:
-            *((int8_t*) frame.cpu.general.ecx) = read(
-                *(struct FAT32DriverRequest*) frame.cpu.general.ebx
-            );
-            break;
+// File handle is only usable by process that open it
+static bool syscall_is_file_owned(int32_t fd) {
+    return file_is_owned(fd, process_get_current_running_pcb_pointer()->metadata.pid);
+}
 
-        case 4:
-            get_keyboard_buffer((char*) frame.cpu.general.ebx);
-            break;
+static void syscall_read(struct InterruptFrame *frame) {
+    // read() transfer whole clusters, last cluster may go past buffer_size
+    struct FAT32DriverRequest request = *(struct FAT32DriverRequest*) frame->cpu.general.ebx;
+    uint32_t transfer_size = (request.buffer_size + CLUSTER_SIZE - 1) / CLUSTER_SIZE * CLUSTER_SIZE;
+    *((int8_t*) frame->cpu.general.ecx) = process_prefault_user_range(request.buf, transfer_size, true)
+        ? read(request) : -1;
+}
 
-        case 5:
-            putchar(*((char*) frame.cpu.general.ebx), 0xF);
-            break;
+static void syscall_keyboard_read(struct InterruptFrame *frame) {
+    // Block until keyboard ISR fill the buffer then retry, receiving input mark process as interactive
+    get_keyboard_buffer((char*) frame->cpu.general.ebx);
+    if (*((char*) frame->cpu.general.ebx) == 0) {
+        struct Context ctx = interrupt_frame_to_context(frame);
+        ctx.eip -= SYSCALL_INSTRUCTION_SIZE;
+        scheduler_block_current_process(&_keyboard_wait_queue, ctx);
+    }
+    scheduler_boost_current_process();
+}
 
-        case 6:
-            puts(
-                (char*) frame.cpu.general.ebx, 
-                frame.cpu.general.ecx, 
-                frame.cpu.general.edx
-            ); // Assuming puts() exist in kernel
-            break;
+static void syscall_putchar(struct InterruptFrame *frame) {
+    putchar(*((char*) frame->cpu.general.ebx), 0xF);
+}
 
-        case 7: 
-            keyboard_state_activate();
-            break;
+static void syscall_puts(struct InterruptFrame *frame) {
+    puts(
+        (char*) frame->cpu.general.ebx, 
+        frame->cpu.general.ecx, 
+        frame->cpu.general.edx
+    ); // Assuming puts() exist in kernel
+}
 
-        case 8:
-            *((uint32_t*) frame.cpu.general.ecx) = process_create_user_process(
-                *((struct FAT32DriverRequest*) frame.cpu.general.ebx)
-            );
-            break;
+static void syscall_keyboard_activate(struct InterruptFrame *frame) {
+    (void) frame;
+    keyboard_state_activate();
+}
 
-        case 9:
-            process_destroy(frame.cpu.general.ebx);
-            break;
+static void syscall_process_create(struct InterruptFrame *frame) {
+    *((uint32_t*) frame->cpu.general.ecx) = process_create_user_process(
+        *((struct FAT32DriverRequest*) frame->cpu.general.ebx)
+    );
+}
 
-        case 10:
-            process_destroy(
-                process_get_current_running_pcb_pointer()->metadata.pid
-            );
-            break;
+static void syscall_process_destroy(struct InterruptFrame *frame) {
+    // Process may destroy itself, its PCB is no longer running afterward
+    process_destroy(frame->cpu.general.ebx);
+    if (process_get_current_running_pcb_pointer() == NULL)
+        scheduler_switch_to_next_process();
+}
 
-        case 11:
-            puts_position(
-                (char*) frame.cpu.general.ebx,
-                frame.cpu.general.ecx,
-                frame.cpu.general.edx
-            );
-            break;
+static void syscall_exit(struct InterruptFrame *frame) {
+    (void) frame;
+    process_destroy(
+        process_get_current_running_pcb_pointer()->metadata.pid
+    );
+    scheduler_switch_to_next_process();
+}
 
-        case 12:
-            *((struct CMOSTimeRTC*) frame.cpu.general.ebx) = cmos_get_current_driver_data();
-            break;
+static void syscall_puts_position(struct InterruptFrame *frame) {
+    puts_position(
+        (char*) frame->cpu.general.ebx,
+        frame->cpu.general.ecx,
+        frame->cpu.general.edx
+    );
+}
+
+static void syscall_cmos_time(struct InterruptFrame *frame) {
+    // Cached by RTC interrupt, ecx optionally receive monotonic millisecond
+    *((struct CMOSTimeRTC*) frame->cpu.general.ebx) = cmos_get_current_driver_data();
+    if (frame->cpu.general.ecx != 0)
+        *((uint32_t*) frame->cpu.general.ecx) = cmos_get_monotonic_ms();
+}
+
+static void syscall_buffer_cache_statistic(struct InterruptFrame *frame) {
+    *((struct BufferCacheStatistic*) frame->cpu.general.ebx) = buffer_cache_get_statistic();
+}
+
+static void syscall_file_open(struct InterruptFrame *frame) {
+    *((int32_t*) frame->cpu.general.edx) = file_open(
+        *((struct FAT32DriverRequest*) frame->cpu.general.ebx),
+        frame->cpu.general.ecx,
+        process_get_current_running_pcb_pointer()->metadata.pid
+    );
+}
+
+static void syscall_file_read(struct InterruptFrame *frame) {
+    struct FileRequest request = *((struct FileRequest*) frame->cpu.general.ebx);
+    *((int32_t*) frame->cpu.general.ecx) = syscall_is_file_owned(request.fd) && process_prefault_user_range(request.buf, request.size, true)
+        ? file_read(request.fd, request.buf, request.size) : -1;
+}
+
+static void syscall_file_write(struct InterruptFrame *frame) {
+    struct FileRequest request = *((struct FileRequest*) frame->cpu.general.ebx);
+    *((int32_t*) frame->cpu.general.ecx) = syscall_is_file_owned(request.fd) && process_prefault_user_range(request.buf, request.size, false)
+        ? file_write(request.fd, request.buf, request.size) : -1;
+}
+
+static void syscall_file_seek(struct InterruptFrame *frame) {
+    struct FileRequest request = *((struct FileRequest*) frame->cpu.general.ebx);
+    *((int32_t*) frame->cpu.general.ecx) = syscall_is_file_owned(request.fd)
+        ? file_seek(request.fd, request.offset, request.whence) : -1;
+}
+
+static void syscall_file_close(struct InterruptFrame *frame) {
+    *((int8_t*) frame->cpu.general.ecx) = syscall_is_file_owned(frame->cpu.general.ebx)
+        ? file_close(frame->cpu.general.ebx) : -1;
+}
+
+static void syscall_frame_allocator_statistic(struct InterruptFrame *frame) {
+    *((struct FrameAllocatorStatistic*) frame->cpu.general.ebx) = frame_allocator_get_statistic();
+}
+
+static void syscall_slab_statistic(struct InterruptFrame *frame) {
+    *((struct SlabStatistic*) frame->cpu.general.ebx) = slab_get_statistic();
+}
+
+static void syscall_fork(struct InterruptFrame *frame) {
+    // Child inherit return slot holding 0, parent slot is written after fork and get private copy
+    int32_t *retval = (int32_t*) frame->cpu.general.ebx;
+    *retval = 0;
+    *retval = process_fork(interrupt_frame_to_context(frame));
+}
+
+static void syscall_image_cache_statistic(struct InterruptFrame *frame) {
+    *((struct ImageCacheStatistic*) frame->cpu.general.ebx) = image_cache_get_statistic();
+}
+
+static void syscall_set_nice(struct InterruptFrame *frame) {
+    *((int8_t*) frame->cpu.general.edx) = scheduler_set_nice(frame->cpu.general.ebx, frame->cpu.general.ecx);
+}
+
+static void syscall_sleep(struct InterruptFrame *frame) {
+    // Sleep for ebx milliseconds, rounded up into timer tick
+    uint32_t ms   = frame->cpu.general.ebx;
+    uint32_t tick = ms / 1000 * PIT_TIMER_FREQUENCY + (ms % 1000 * PIT_TIMER_FREQUENCY + 999) / 1000;
+    if (tick == 0)
+        scheduler_yield(interrupt_frame_to_context(frame));
+    scheduler_sleep_current_process(tick, interrupt_frame_to_context(frame));
+}
+
+static void syscall_wait(struct InterruptFrame *frame) {
+    // Block until process ebx exit then retry, return immediately if it does not exist
+    struct ProcessControlBlock *pcb = process_get_pcb_by_pid(frame->cpu.general.ebx);
+    if (pcb != NULL && pcb != process_get_current_running_pcb_pointer()) {
+        struct Context ctx = interrupt_frame_to_context(frame);
+        ctx.eip -= SYSCALL_INSTRUCTION_SIZE;
+        scheduler_block_current_process(&pcb->scheduler.exit_wait_queue, ctx);
+    }
+}
+
+// Empty syscall for measuring entry & exit overhead
+static void syscall_null(struct InterruptFrame *frame) {
+    (void) frame;
+}
+
+static void syscall_string_benchmark(struct InterruptFrame *frame) {
+    // Scratch area is taken from frame allocator, kernel heap cannot hold it
+    struct StringBenchmarkResult *result = (struct StringBenchmarkResult*) frame->cpu.general.ebx;
+    uint8_t order = 0;
+    while (((uint32_t) PAGE_FRAME_SIZE << order) < STRING_BENCHMARK_BUFFER_SIZE)
+        order++;
+    uint32_t physical_addr = frame_allocate(order);
+    if (physical_addr == FRAME_ALLOCATE_FAIL) {
+        result->variant_count = 0;
+        return;
     }
-}
\ No newline at end of file
+    string_benchmark_run(PAGING_DIRECT_MAP(physical_addr), result);
+    frame_free(physical_addr, order);
+}
+
+static void syscall_timer_statistic(struct InterruptFrame *frame) {
+    *((struct TimerStatistic*) frame->cpu.general.ebx) = (struct TimerStatistic) {
+        .tickless        = timer_state.tickless,
+        .interrupt_count = timer_state.interrupt_count,
+        .clock_tick      = scheduler_get_clock_tick(),
+    };
+}
+
+static void syscall_clock_gettime(struct InterruptFrame *frame) {
+    int8_t retcode = clocksource_get_time(frame->cpu.general.ebx, (struct ClockTimespec*) frame->cpu.general.ecx);
+    if (frame->cpu.general.edx != 0)
+        *((int8_t*) frame->cpu.general.edx) = retcode;
+}
+
+// Syscall handler indexed by eax, unassigned number is ignored
+static void (*const syscall_table[SYSCALL_COUNT])(struct InterruptFrame *frame) = {
+    [0]  = syscall_read,
+    [4]  = syscall_keyboard_read,
+    [5]  = syscall_putchar,
+    [6]  = syscall_puts,
+    [7]  = syscall_keyboard_activate,
+    [8]  = syscall_process_create,
+    [9]  = syscall_process_destroy,
+    [10] = syscall_exit,
+    [11] = syscall_puts_position,
+    [12] = syscall_cmos_time,
+    [13] = syscall_buffer_cache_statistic,
+    [14] = syscall_file_open,
+    [15] = syscall_file_read,
+    [16] = syscall_file_write,
+    [17] = syscall_file_seek,
+    [18] = syscall_file_close,
+    [19] = syscall_frame_allocator_statistic,
+    [20] = syscall_slab_statistic,
+    [21] = syscall_fork,
+    [22] = syscall_image_cache_statistic,
+    [23] = syscall_set_nice,
+    [24] = syscall_sleep,
+    [25] = syscall_wait,
+    [26] = syscall_null,
+    [27] = syscall_string_benchmark,
+    [28] = syscall_timer_statistic,
+    [29] = syscall_clock_gettime,
+};
+
+void syscall(struct InterruptFrame *frame) {
+    uint32_t number = frame->cpu.general.eax;
+    if (number < SYSCALL_COUNT && syscall_table[number] != NULL)
+        syscall_table[number](frame);
+}
@@ -1,5 +1,7 @@
 extern main_interrupt_handler
+extern syscall
 global isr_stub_table
+global sysenter_handler
 
 ; Generic handler section for interrupt
 call_generic_handler:
@@ -73,6 +75,47 @@ segment_register_setup:
 
 
 
+; Fast syscall entry, esp is loaded from MSR_SYSENTER_ESP with IF cleared
+; User state expected at this label
+; eax, ebx, ecx, edx : syscall number & arguments, same as int 0x30
+; esi                : return address
+; edi                : user esp
+sysenter_handler:
+    ; Build same InterruptFrame as int 0x30, context saved by blocking syscall is resumed with iret
+    pushf
+    or   dword [esp], 0x200 ; eflags, resumed context run with interrupt enabled
+    push dword 0x18 | 0x3   ; cs, GDT_USER_CODE_SELECTOR with user privilege
+    push esi                ; eip
+    push dword 0            ; error code
+    push dword 0x30         ; int_number
+
+    ; Segment registers are left as user data selector, flat segment is usable from kernel
+    push dword 0x20 | 0x3   ; ds
+    push dword 0x20 | 0x3   ; es
+    push dword 0x20 | 0x3   ; fs
+    push dword 0x20 | 0x3   ; gs
+    pushad
+    mov  [esp+12], edi      ; CPURegister.stack.esp is user esp
+
+    ; syscall(struct InterruptFrame *frame)
+    push esp
+    call syscall
+    add  esp, 4
+
+    popad
+    add  esp, 24            ; Segment registers, int_number & error code
+
+    ; sysexit load eip from edx & esp from ecx, sti take effect after sysexit
+    mov  edx, esi
+    mov  ecx, edi
+    btr  dword [esp+8], 9
+    add  esp, 8
+    popf
+    sti
+    sysexit
+
+
+
 ; Macro for creating interrupt handler that only push interrupt number
 ; Stack will have these value that pushed automatically by CPU
 ; [esp + 20] ss  (Only for inter-privilege)
@@ -42,4 +42,47 @@ uint16_t in16(uint16_t port) {
         : "Nd"(port)
     );
     return result;
-}
\ No newline at end of file
+}
+void out32(uint16_t port, uint32_t data) {
+    __asm__(
+        "outl %0, %1"
+        : // <Empty output operand>
+        : "a"(data), "Nd"(port)
+    );
+}
+
+uint32_t in32(uint16_t port) {
+    uint32_t result;
+    __asm__ volatile(
+        "inl %1, %0"
+        : "=a"(result)
+        : "Nd"(port)
+    );
+    return result;
+}
+
+uint64_t read_msr(uint32_t msr) {
+    uint32_t low, high;
+    __asm__ volatile(
+        "rdmsr"
+        : "=a"(low), "=d"(high)
+        : "c"(msr)
+    );
+    return ((uint64_t) high << 32) | low;
+}
+
+void write_msr(uint32_t msr, uint64_t value) {
+    __asm__ volatile(
+        "wrmsr"
+        : // <Empty output operand>
+        : "c"(msr), "a"((uint32_t) value), "d"((uint32_t) (value >> 32))
+    );
+}
+
+void cpuid(uint32_t leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+    __asm__ volatile(
+        "cpuid"
+        : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+        : "a"(leaf), "c"(0)
+    );
+}
@@ -0,0 +1,251 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/filesystem/directory-index.h"
+#include "header/stdlib/string.h"
+
+/**
+ * Directory index states, nodes of all indexed directories share single hash table and node pool
+ *
+ * @param directory      Indexed directory slots
+ * @param node           Node pool
+ * @param hash_head      First node index for every hash bucket
+ * @param free_head      First unused node index, chained with hash_next
+ * @param access_counter Incremented on every directory access, for LRU eviction
+ * @param initialized    Lazy initialization flag
+ * @param disabled       Directory index is turned off, every directory is not loaded
+ */
+static struct {
+    struct DirectoryIndexDirectory directory[DIRECTORY_INDEX_DIRECTORY_COUNT];
+    struct DirectoryIndexNode      node[DIRECTORY_INDEX_NODE_COUNT];
+    int16_t                        hash_head[DIRECTORY_INDEX_BUCKET_COUNT];
+    int16_t                        free_head;
+    uint32_t                       access_counter;
+    bool                           initialized;
+    bool                           disabled;
+} directory_index_state = {
+    .initialized = false,
+    .disabled    = false,
+};
+
+
+
+// -- Internal helper --
+static void directory_index_initialize(void) {
+    for (int16_t i = 0; i < DIRECTORY_INDEX_BUCKET_COUNT; i++)
+        directory_index_state.hash_head[i] = DIRECTORY_INDEX_INVALID_INDEX;
+    for (int16_t i = 0; i < DIRECTORY_INDEX_NODE_COUNT; i++)
+        directory_index_state.node[i].hash_next = (i == DIRECTORY_INDEX_NODE_COUNT - 1) ? DIRECTORY_INDEX_INVALID_INDEX : i + 1;
+    for (uint32_t i = 0; i < DIRECTORY_INDEX_DIRECTORY_COUNT; i++)
+        directory_index_state.directory[i].valid = false;
+    directory_index_state.free_head   = 0;
+    directory_index_state.initialized = true;
+}
+
+// FNV-1a over directory cluster, name, and ext
+static uint32_t directory_index_hash(uint32_t dir_cluster, const char name[8], const char ext[3]) {
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < 4; i++)
+        hash = (hash ^ ((dir_cluster >> (8*i)) & 0xFF)) * 16777619u;
+    for (uint32_t i = 0; i < 8; i++)
+        hash = (hash ^ (uint8_t) name[i]) * 16777619u;
+    for (uint32_t i = 0; i < 3; i++)
+        hash = (hash ^ (uint8_t) ext[i]) * 16777619u;
+    return hash & (DIRECTORY_INDEX_BUCKET_COUNT - 1);
+}
+
+// Get directory slot index, -1 if directory is not indexed
+static int32_t directory_index_find_directory(uint32_t dir_cluster) {
+    if (!directory_index_state.initialized)
+        directory_index_initialize();
+    for (int32_t i = 0; i < DIRECTORY_INDEX_DIRECTORY_COUNT; i++) {
+        struct DirectoryIndexDirectory *directory = &directory_index_state.directory[i];
+        if (directory->valid && directory->cluster_number == dir_cluster) {
+            directory->last_access = ++directory_index_state.access_counter;
+            return i;
+        }
+    }
+    return DIRECTORY_INDEX_INVALID_INDEX;
+}
+
+// Search node pointer-to-pointer in hash chain, for both lookup and unlink
+static int16_t* directory_index_find_node(uint8_t slot, const char name[8], const char ext[3]) {
+    uint32_t bucket   = directory_index_hash(directory_index_state.directory[slot].cluster_number, name, ext);
+    int16_t *iterator = &directory_index_state.hash_head[bucket];
+    while (*iterator != DIRECTORY_INDEX_INVALID_INDEX) {
+        struct DirectoryIndexNode *node = &directory_index_state.node[*iterator];
+        if (node->directory_slot == slot && !memcmp(node->name, name, 8) && !memcmp(node->ext, ext, 3))
+            break;
+        iterator = &node->hash_next;
+    }
+    return iterator;
+}
+
+// Return all nodes owned by directory slot into free list, walk every bucket
+static void directory_index_drop(uint8_t slot) {
+    struct DirectoryIndexDirectory *directory = &directory_index_state.directory[slot];
+    for (uint32_t bucket = 0; bucket < DIRECTORY_INDEX_BUCKET_COUNT && directory->node_count > 0; bucket++) {
+        int16_t *iterator = &directory_index_state.hash_head[bucket];
+        while (*iterator != DIRECTORY_INDEX_INVALID_INDEX) {
+            int16_t                    index = *iterator;
+            struct DirectoryIndexNode *node  = &directory_index_state.node[index];
+            if (node->directory_slot != slot) {
+                iterator = &node->hash_next;
+                continue;
+            }
+            *iterator                       = node->hash_next;
+            node->hash_next                 = directory_index_state.free_head;
+            directory_index_state.free_head = index;
+            directory->node_count--;
+        }
+    }
+    directory->valid = false;
+}
+
+// Evict least recently used directory other than keep_slot, return false if nothing evictable
+static bool directory_index_evict(int32_t keep_slot) {
+    int32_t victim = DIRECTORY_INDEX_INVALID_INDEX;
+    for (int32_t i = 0; i < DIRECTORY_INDEX_DIRECTORY_COUNT; i++) {
+        struct DirectoryIndexDirectory *directory = &directory_index_state.directory[i];
+        if (i == keep_slot || !directory->valid)
+            continue;
+        if (victim == DIRECTORY_INDEX_INVALID_INDEX || directory->last_access < directory_index_state.directory[victim].last_access)
+            victim = i;
+    }
+    if (victim == DIRECTORY_INDEX_INVALID_INDEX)
+        return false;
+    directory_index_drop(victim);
+    return true;
+}
+
+
+
+// -- Public interfaces --
+void directory_index_reset(void) {
+    directory_index_initialize();
+}
+
+void directory_index_set_enable(bool enable) {
+    directory_index_initialize();
+    directory_index_state.disabled = !enable;
+}
+
+bool directory_index_is_loaded(uint32_t dir_cluster) {
+    int32_t slot = directory_index_find_directory(dir_cluster);
+    return slot != DIRECTORY_INDEX_INVALID_INDEX && !directory_index_state.directory[slot].overflow;
+}
+
+bool directory_index_begin(uint32_t dir_cluster) {
+    if (directory_index_state.disabled)
+        return false;
+
+    // Directory bigger than node pool is not indexed again until evicted or invalidated
+    int32_t existing_slot = directory_index_find_directory(dir_cluster);
+    if (existing_slot != DIRECTORY_INDEX_INVALID_INDEX && directory_index_state.directory[existing_slot].overflow)
+        return false;
+    directory_index_invalidate(dir_cluster);
+
+    int32_t slot = DIRECTORY_INDEX_INVALID_INDEX;
+    for (int32_t i = 0; i < DIRECTORY_INDEX_DIRECTORY_COUNT && slot == DIRECTORY_INDEX_INVALID_INDEX; i++)
+        if (!directory_index_state.directory[i].valid)
+            slot = i;
+    if (slot == DIRECTORY_INDEX_INVALID_INDEX) {
+        directory_index_evict(DIRECTORY_INDEX_INVALID_INDEX);
+        return directory_index_begin(dir_cluster);
+    }
+
+    struct DirectoryIndexDirectory *directory = &directory_index_state.directory[slot];
+    directory->cluster_number = dir_cluster;
+    directory->valid          = true;
+    directory->overflow       = false;
+    directory->free_hint      = 0;
+    directory->node_count     = 0;
+    directory->last_access    = ++directory_index_state.access_counter;
+    return true;
+}
+
+bool directory_index_insert(uint32_t dir_cluster, const char name[8], const char ext[3], uint32_t entry_index) {
+    int32_t slot = directory_index_find_directory(dir_cluster);
+    if (slot == DIRECTORY_INDEX_INVALID_INDEX || directory_index_state.directory[slot].overflow)
+        return false;
+
+    // Keep lowest entry index on duplicate name, same as linear scan
+    struct DirectoryIndexDirectory *directory = &directory_index_state.directory[slot];
+    if (*directory_index_find_node(slot, name, ext) != DIRECTORY_INDEX_INVALID_INDEX)
+        return true;
+
+    while (directory_index_state.free_head == DIRECTORY_INDEX_INVALID_INDEX) {
+        if (!directory_index_evict(slot)) {
+            directory_index_drop(slot);
+            directory->valid    = true;
+            directory->overflow = true;
+            return false;
+        }
+    }
+
+    int16_t                    index  = directory_index_state.free_head;
+    struct DirectoryIndexNode *node   = &directory_index_state.node[index];
+    uint32_t                   bucket = directory_index_hash(dir_cluster, name, ext);
+    directory_index_state.free_head = node->hash_next;
+    memcpy(node->name, name, 8);
+    memcpy(node->ext,  ext,  3);
+    node->directory_slot = slot;
+    node->entry_index    = entry_index;
+    node->hash_next      = directory_index_state.hash_head[bucket];
+    directory_index_state.hash_head[bucket] = index;
+    directory->node_count++;
+
+    if (entry_index == directory->free_hint)
+        directory->free_hint++;
+    return true;
+}
+
+void directory_index_remove(uint32_t dir_cluster, const char name[8], const char ext[3]) {
+    int32_t slot = directory_index_find_directory(dir_cluster);
+    if (slot == DIRECTORY_INDEX_INVALID_INDEX)
+        return;
+
+    int16_t *iterator = directory_index_find_node(slot, name, ext);
+    if (*iterator == DIRECTORY_INDEX_INVALID_INDEX)
+        return;
+
+    struct DirectoryIndexDirectory *directory = &directory_index_state.directory[slot];
+    int16_t                         index     = *iterator;
+    struct DirectoryIndexNode      *node      = &directory_index_state.node[index];
+    if (node->entry_index < directory->free_hint)
+        directory->free_hint = node->entry_index;
+    *iterator                       = node->hash_next;
+    node->hash_next                 = directory_index_state.free_head;
+    directory_index_state.free_head = index;
+    directory->node_count--;
+}
+
+int32_t directory_index_lookup(uint32_t dir_cluster, const char name[8], const char ext[3]) {
+    int32_t slot = directory_index_find_directory(dir_cluster);
+    if (slot == DIRECTORY_INDEX_INVALID_INDEX)
+        return -1;
+
+    int16_t index = *directory_index_find_node(slot, name, ext);
+    if (index == DIRECTORY_INDEX_INVALID_INDEX)
+        return -1;
+    return directory_index_state.node[index].entry_index;
+}
+
+uint32_t directory_index_get_free_hint(uint32_t dir_cluster) {
+    int32_t slot = directory_index_find_directory(dir_cluster);
+    if (slot == DIRECTORY_INDEX_INVALID_INDEX)
+        return 0;
+    return directory_index_state.directory[slot].free_hint;
+}
+
+void directory_index_set_free_hint(uint32_t dir_cluster, uint32_t free_hint) {
+    int32_t slot = directory_index_find_directory(dir_cluster);
+    if (slot != DIRECTORY_INDEX_INVALID_INDEX && free_hint > directory_index_state.directory[slot].free_hint)
+        directory_index_state.directory[slot].free_hint = free_hint;
+}
+
+void directory_index_invalidate(uint32_t dir_cluster) {
+    int32_t slot = directory_index_find_directory(dir_cluster);
+    if (slot != DIRECTORY_INDEX_INVALID_INDEX)
+        directory_index_drop(slot);
+}
@@ -1,5 +1,39 @@
 #include "header/driver/disk.h"
+#include "header/driver/pci.h"
 #include "header/cpu/portio.h"
+#include "header/cpu/interrupt.h"
+#include "header/memory/paging.h"
+
+/**
+ * ATA driver states
+ * 
+ * @param dma_available   Bus master IDE controller found during disk_initialize()
+ * @param dma_enabled     Use DMA for transfer, can be turned off for comparing with PIO
+ * @param bus_master_base I/O port base of primary channel bus master registers
+ * @param queue_head      Request currently in flight, followed by pending requests
+ * @param queue_tail      Last pending request
+ * @param busy            Whether queue_head is already started
+ * @param block_count     Disk size in block, from IDENTIFY DEVICE
+ */
+static struct {
+    bool                dma_available;
+    bool                dma_enabled;
+    uint16_t            bus_master_base;
+    struct BlockRequest *queue_head;
+    struct BlockRequest *queue_tail;
+    bool                busy;
+    uint32_t            block_count;
+} ata_driver_state = {
+    .dma_available = false,
+    .dma_enabled   = false,
+    .queue_head    = NULL,
+    .queue_tail    = NULL,
+    .busy          = false,
+    .block_count   = 0,
+};
+
+__attribute__((aligned(sizeof(struct ATAPhysicalRegionDescriptor) * ATA_PRD_MAX_COUNT)))
+static struct ATAPhysicalRegionDescriptor prd_table[ATA_PRD_MAX_COUNT];
 
 static void ATA_busy_wait() {
     while (in(0x1F7) & ATA_STATUS_BSY);
@@ -9,38 +43,299 @@ static void ATA_DRQ_wait() {
     while (!(in(0x1F7) & ATA_STATUS_RDY));
 }
 
-void read_blocks(void *ptr, uint32_t logical_block_address, uint8_t block_count) {
+static void ATA_send_command(uint32_t logical_block_address, uint8_t block_count, uint8_t command) {
     ATA_busy_wait();
     out(0x1F6, 0xE0 | ((logical_block_address >> 24) & 0xF));
     out(0x1F2, block_count);
     out(0x1F3, (uint8_t) logical_block_address);
     out(0x1F4, (uint8_t) (logical_block_address >> 8));
     out(0x1F5, (uint8_t) (logical_block_address >> 16));
-    out(0x1F7, 0x20);
+    out(0x1F7, command);
+}
 
-    uint16_t *target = (uint16_t*) ptr;
-    for (uint32_t i = 0; i < block_count; i++) {
-        ATA_busy_wait();
-        ATA_DRQ_wait();
+
+
+/* -- ATA PIO -- */
+// Transfer single block of request, buffer may live in another address space when called from ISR
+static void ATA_pio_transfer_block(struct BlockRequest *request) {
+    struct PageDirectory *current_page_dir = paging_get_current_page_directory_addr();
+    if (current_page_dir != request->page_dir)
+        paging_use_page_directory(request->page_dir);
+
+    uint16_t *buf = (uint16_t*) request->buf + HALF_BLOCK_SIZE*request->block_done;
+    if (request->is_write) {
+        for (uint32_t j = 0; j < HALF_BLOCK_SIZE; j++)
+            out16(0x1F0, buf[j]);
+    } else {
         for (uint32_t j = 0; j < HALF_BLOCK_SIZE; j++)
-            target[j] = in16(0x1F0);
-        target += HALF_BLOCK_SIZE;
+            buf[j] = in16(0x1F0);
     }
+
+    if (current_page_dir != request->page_dir)
+        paging_use_page_directory(current_page_dir);
 }
 
-void write_blocks(const void *ptr, uint32_t logical_block_address, uint8_t block_count) {
-    ATA_busy_wait();
-    out(0x1F6, 0xE0 | ((logical_block_address >> 24) & 0xF));
-    out(0x1F2, block_count);
-    out(0x1F3, (uint8_t) logical_block_address);
-    out(0x1F4, (uint8_t) (logical_block_address >> 8));
-    out(0x1F5, (uint8_t) (logical_block_address >> 16));
-    out(0x1F7, 0x30);
 
-    for (uint32_t i = 0; i < block_count; i++) {
+
+/* -- ATA Bus Master DMA -- */
+// Bus master write memory without MMU check, read into read-only or copy-on-write page fall back to PIO that respect CR0.WP
+static bool ATA_build_prd_table(struct PageDirectory *page_dir, const void *ptr, uint32_t byte_count, bool to_memory) {
+    uint32_t virtual_addr = (uint32_t) ptr;
+    uint32_t prd_index    = 0;
+    while (byte_count > 0) {
+        uint32_t physical_addr;
+        bool     is_mapped = to_memory
+            ? paging_virtual_to_writable_physical_addr(page_dir, (void*) virtual_addr, &physical_addr)
+            : paging_virtual_to_physical_addr(page_dir, (void*) virtual_addr, &physical_addr);
+        if (!is_mapped)
+            return false;
+
+        // Single region cannot cross 64 KiB boundary nor page frame boundary
+        uint32_t region_size = ATA_PRD_REGION_SIZE_MAX - (physical_addr & (ATA_PRD_REGION_SIZE_MAX - 1));
+        uint32_t frame_left  = PAGE_FRAME_SIZE - (virtual_addr & (PAGE_FRAME_SIZE - 1));
+        if (region_size > frame_left)
+            region_size = frame_left;
+        if (region_size > byte_count)
+            region_size = byte_count;
+
+        // Physically contiguous pages inside same 64 KiB window is merged into previous region
+        if (prd_index > 0 && (physical_addr & (ATA_PRD_REGION_SIZE_MAX - 1)) != 0
+                && prd_table[prd_index - 1].physical_addr + prd_table[prd_index - 1].byte_count == physical_addr) {
+            prd_table[prd_index - 1].byte_count = (prd_table[prd_index - 1].byte_count + region_size) & 0xFFFF;
+        } else {
+            if (prd_index >= ATA_PRD_MAX_COUNT)
+                return false;
+            prd_table[prd_index].physical_addr = physical_addr;
+            prd_table[prd_index].byte_count    = region_size & 0xFFFF; // 0 is interpreted as 64 KiB
+            prd_table[prd_index].flag          = 0;
+            prd_index++;
+        }
+        virtual_addr += region_size;
+        byte_count   -= region_size;
+    }
+    prd_table[prd_index - 1].flag = ATA_PRD_FLAG_END_OF_TABLE;
+    return true;
+}
+
+static bool ATA_dma_start(struct BlockRequest *request) {
+    uint32_t prd_table_physical_addr;
+    uint16_t bus_master_base = ata_driver_state.bus_master_base;
+    if (!ATA_build_prd_table(request->page_dir, request->buf, request->block_count * BLOCK_SIZE, !request->is_write))
+        return false;
+    paging_virtual_to_physical_addr(paging_get_current_page_directory_addr(), prd_table, &prd_table_physical_addr);
+
+    // Setup bus master: PRD table, clear interrupt & error bit (write 1 to clear), and transfer direction
+    uint8_t direction = request->is_write ? 0 : ATA_BMI_COMMAND_READ;
+    out(bus_master_base + ATA_BMI_COMMAND, direction);
+    out32(bus_master_base + ATA_BMI_PRDT_ADDRESS, prd_table_physical_addr);
+    out(bus_master_base + ATA_BMI_STATUS, in(bus_master_base + ATA_BMI_STATUS) | ATA_BMI_STATUS_IRQ | ATA_BMI_STATUS_ERROR);
+
+    uint8_t command = request->is_write ? ATA_COMMAND_WRITE_DMA : ATA_COMMAND_READ_DMA;
+    ATA_send_command(request->logical_block_address, request->block_count, command);
+    out(bus_master_base + ATA_BMI_COMMAND, direction | ATA_BMI_COMMAND_START);
+    return true;
+}
+
+// Stop bus master and return true if transfer success
+static bool ATA_dma_stop(void) {
+    uint16_t bus_master_base   = ata_driver_state.bus_master_base;
+    uint8_t  bus_master_status = in(bus_master_base + ATA_BMI_STATUS);
+    out(bus_master_base + ATA_BMI_COMMAND, 0);
+    out(bus_master_base + ATA_BMI_STATUS, bus_master_status | ATA_BMI_STATUS_IRQ | ATA_BMI_STATUS_ERROR);
+    return !(bus_master_status & ATA_BMI_STATUS_ERROR);
+}
+
+
+
+/* -- Request queue -- */
+static void ATA_start_request(struct BlockRequest *request) {
+    ata_driver_state.busy = true;
+    request->status       = BLOCK_REQUEST_IN_FLIGHT;
+    request->block_done   = 0;
+    if (request->use_dma && ATA_dma_start(request))
+        return;
+
+    // PIO, drive will raise IRQ for every block read or written
+    request->use_dma = false;
+    uint8_t command  = request->is_write ? ATA_COMMAND_WRITE_PIO : ATA_COMMAND_READ_PIO;
+    ATA_send_command(request->logical_block_address, request->block_count, command);
+    if (request->is_write) {
+        // First block need to be sent before the drive raise any interrupt
         ATA_busy_wait();
         ATA_DRQ_wait();
-        for (uint32_t j = 0; j < HALF_BLOCK_SIZE; j++)
-            out16(0x1F0, ((uint16_t*) ptr)[HALF_BLOCK_SIZE*i + j]);
+        ATA_pio_transfer_block(request);
     }
-}
\ No newline at end of file
+}
+
+static void ATA_complete_request(BLOCK_REQUEST_STATUS status) {
+    struct BlockRequest *request = ata_driver_state.queue_head;
+    ata_driver_state.queue_head  = request->next;
+    if (ata_driver_state.queue_head == NULL)
+        ata_driver_state.queue_tail = NULL;
+    ata_driver_state.busy = false;
+
+    request->next   = NULL;
+    request->status = status;
+    if (request->callback != NULL)
+        request->callback(request);
+
+    // Callback may already submit and start new request
+    if (!ata_driver_state.busy && ata_driver_state.queue_head != NULL)
+        ATA_start_request(ata_driver_state.queue_head);
+}
+
+void disk_submit_request(struct BlockRequest *request) {
+    uint32_t eflags;
+    __asm__ volatile("pushf; pop %0; cli" : "=r"(eflags) : /* <Empty> */ : "memory");
+
+    request->next     = NULL;
+    request->status   = BLOCK_REQUEST_PENDING;
+    request->page_dir = paging_get_current_page_directory_addr();
+    request->use_dma  = ata_driver_state.dma_enabled;
+    if (ata_driver_state.queue_tail != NULL)
+        ata_driver_state.queue_tail->next = request;
+    else
+        ata_driver_state.queue_head = request;
+    ata_driver_state.queue_tail = request;
+
+    if (!ata_driver_state.busy)
+        ATA_start_request(ata_driver_state.queue_head);
+
+    __asm__ volatile("push %0; popf" : /* <Empty> */ : "r"(eflags) : "memory", "cc");
+}
+
+void disk_wait_request(struct BlockRequest *request) {
+    uint32_t eflags;
+    __asm__ volatile("pushf; pop %0; cli" : "=r"(eflags) : /* <Empty> */ : "memory");
+
+    // sti will only take effect after hlt, no interrupt will be missed between check & hlt
+    while (request->status == BLOCK_REQUEST_PENDING || request->status == BLOCK_REQUEST_IN_FLIGHT)
+        __asm__ volatile("sti; hlt; cli" : /* <Empty> */ : /* <Empty> */ : "memory");
+
+    __asm__ volatile("push %0; popf" : /* <Empty> */ : "r"(eflags) : "memory", "cc");
+}
+
+void disk_isr(void) {
+    struct BlockRequest *request = ata_driver_state.queue_head;
+    bool dma_success = true;
+    if (request != NULL && ata_driver_state.busy && request->use_dma)
+        dma_success = ATA_dma_stop();
+
+    // Reading status register also acknowledge drive interrupt
+    uint8_t ata_status = in(0x1F7);
+    pic_ack(IRQ_PRIMARY_ATA);
+    if (request == NULL || !ata_driver_state.busy)
+        return;
+
+    if (request->use_dma) {
+        if (dma_success && !(ata_status & (ATA_STATUS_ERR | ATA_STATUS_DF))) {
+            ATA_complete_request(BLOCK_REQUEST_DONE);
+        } else {
+            // Retry whole request with PIO
+            request->use_dma = false;
+            ATA_start_request(request);
+        }
+    } else if (ata_status & (ATA_STATUS_ERR | ATA_STATUS_DF)) {
+        ATA_complete_request(BLOCK_REQUEST_ERROR);
+    } else if (request->is_write) {
+        // Interrupt is raised after drive done writing previous block
+        request->block_done++;
+        if (request->block_done == request->block_count)
+            ATA_complete_request(BLOCK_REQUEST_DONE);
+        else
+            ATA_pio_transfer_block(request);
+    } else {
+        ATA_pio_transfer_block(request);
+        request->block_done++;
+        if (request->block_done == request->block_count)
+            ATA_complete_request(BLOCK_REQUEST_DONE);
+    }
+}
+
+
+
+/* -- Driver Interfaces -- */
+// Polled IDENTIFY DEVICE, drive interrupt is disabled with nIEN
+static void ATA_identify(void) {
+    uint16_t identify[HALF_BLOCK_SIZE];
+    out(ATA_DEVICE_CONTROL_PIO, ATA_DEVICE_CONTROL_NIEN);
+    ATA_busy_wait();
+    out(0x1F6, 0xA0);
+    out(0x1F7, ATA_COMMAND_IDENTIFY);
+    if (in(0x1F7) == 0)
+        return; // No drive attached
+    
+    ATA_busy_wait();
+    uint8_t status;
+    do {
+        status = in(0x1F7);
+    } while (!(status & (ATA_STATUS_DRQ | ATA_STATUS_ERR)));
+    if (status & ATA_STATUS_ERR)
+        return;
+
+    for (uint32_t i = 0; i < HALF_BLOCK_SIZE; i++)
+        identify[i] = in16(0x1F0);
+    ata_driver_state.block_count = identify[ATA_IDENTIFY_LBA28_BLOCK_COUNT] 
+        | ((uint32_t) identify[ATA_IDENTIFY_LBA28_BLOCK_COUNT + 1] << 16);
+}
+
+void disk_initialize(void) {
+    ATA_identify();
+
+    // Clear nIEN, drive will raise IRQ14 on every completion
+    out(ATA_DEVICE_CONTROL_PIO, 0);
+    activate_primary_ata_interrupt();
+
+    struct PCIDeviceAddress ide_controller;
+    if (!pci_find_device_by_class(PCI_CLASS_MASS_STORAGE, PCI_SUBCLASS_IDE, &ide_controller))
+        return;
+
+    // Primary channel must be in compatibility mode as driver use legacy port 0x1F0
+    uint8_t prog_if = pci_config_read(ide_controller, PCI_OFFSET_CLASS) >> 8;
+    uint32_t bar4   = pci_config_read(ide_controller, PCI_OFFSET_BAR4);
+    if (!(prog_if & PCI_PROG_IF_IDE_BUS_MASTER) || (prog_if & PCI_PROG_IF_IDE_PRIMARY_NATIVE) || !(bar4 & PCI_BAR_IO_SPACE))
+        return;
+
+    uint32_t command = pci_config_read(ide_controller, PCI_OFFSET_COMMAND);
+    pci_config_write(ide_controller, PCI_OFFSET_COMMAND, command | PCI_COMMAND_IO_SPACE | PCI_COMMAND_BUS_MASTER);
+
+    ata_driver_state.bus_master_base = bar4 & PCI_BAR_IO_ADDRESS;
+    ata_driver_state.dma_available   = true;
+    ata_driver_state.dma_enabled     = true;
+}
+
+uint32_t disk_get_block_count(void) {
+    return ata_driver_state.block_count;
+}
+
+bool disk_is_dma_available(void) {
+    return ata_driver_state.dma_available;
+}
+
+void disk_set_dma_enable(bool enable) {
+    ata_driver_state.dma_enabled = enable && ata_driver_state.dma_available;
+}
+
+void read_blocks(void *ptr, uint32_t logical_block_address, uint8_t block_count) {
+    struct BlockRequest request = {
+        .buf                   = ptr,
+        .logical_block_address = logical_block_address,
+        .block_count           = block_count,
+        .is_write              = false,
+        .callback              = NULL,
+    };
+    disk_submit_request(&request);
+    disk_wait_request(&request);
+}
+
+void write_blocks(const void *ptr, uint32_t logical_block_address, uint8_t block_count) {
+    struct BlockRequest request = {
+        .buf                   = (void*) ptr,
+        .logical_block_address = logical_block_address,
+        .block_count           = block_count,
+        .is_write              = true,
+        .callback              = NULL,
+    };
+    disk_submit_request(&request);
+    disk_wait_request(&request);
+}
@@ -3,12 +3,15 @@
 #include <stdint.h>
 
 #include "header/filesystem/fat32.h"
+#include "header/filesystem/buffer-cache.h"
+#include "header/filesystem/image-cache.h"
 #include "header/driver/disk.h"
 #include "header/stdlib/string.h"
 
 // Global variable
 uint8_t *image_storage;
 uint8_t *file_buffer;
+size_t   image_size;
 
 void read_blocks(void *ptr, uint32_t logical_block_address, uint8_t block_count) {
     for (int i = 0; i < block_count; i++) {
@@ -30,26 +33,42 @@ void write_blocks(const void *ptr, uint32_t logical_block_address, uint8_t block
     }
 }
 
+uint32_t disk_get_block_count(void) {
+    return image_size / BLOCK_SIZE;
+}
+
+// No process on host, executable page is never cached
+void image_cache_invalidate(uint32_t first_cluster) {
+    (void) first_cluster;
+}
+
 int main(int argc, char *argv[]) {
     if (argc < 4) {
         fprintf(stderr, "inserter: ./inserter <file to insert> <parent cluster index> <storage>\n");
         exit(1);
     }
 
-    // Read storage into memory, requiring 4 MB memory
-    image_storage = malloc(4*1024*1024);
-    file_buffer   = malloc(4*1024*1024);
-    FILE *fptr    = fopen(argv[3], "r");
-    fread(image_storage, 4*1024*1024, 1, fptr);
+    // Read whole storage into memory, FAT size is derived from storage size
+    FILE *fptr = fopen(argv[3], "r");
+    if (fptr == NULL) {
+        fprintf(stderr, "inserter: cannot open storage %s\n", argv[3]);
+        exit(1);
+    }
+    fseek(fptr, 0, SEEK_END);
+    image_size = ftell(fptr);
+    fseek(fptr, 0, SEEK_SET);
+    image_storage = malloc(image_size);
+    file_buffer   = malloc(image_size);
+    fread(image_storage, image_size, 1, fptr);
     fclose(fptr);
 
-    // Read target file, assuming file is less than 4 MiB
+    // Read target file, assuming file is less than storage size
     FILE *fptr_target = fopen(argv[1], "r");
     size_t filesize   = 0;
     if (fptr_target == NULL)
         filesize = 0;
     else {
-        fread(file_buffer, 4*1024*1024, 1, fptr_target);
+        fread(file_buffer, image_size, 1, fptr_target);
         fseek(fptr_target, 0, SEEK_END);
         filesize = ftell(fptr_target);
         fclose(fptr_target);
@@ -75,9 +94,10 @@ int main(int argc, char *argv[]) {
         default: puts("Error: Unknown error");
     }
 
-    // Write image in memory into original, overwrite them
+    // Flush buffer cache into image then write image in memory into original, overwrite them
+    buffer_cache_sync();
     fptr = fopen(argv[3], "w");
-    fwrite(image_storage, 4*1024*1024, 1, fptr);
+    fwrite(image_storage, image_size, 1, fptr);
     fclose(fptr);
 
     return 0;
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "header/filesystem/fat32.h"
+#include "header/filesystem/buffer-cache.h"
+#include "header/filesystem/image-cache.h"
+#include "header/filesystem/directory-index.h"
+#include "header/driver/disk.h"
+#include "header/stdlib/string.h"
+
+// Small storage keep free space under pressure, FAT is sized from this
+#define BENCHMARK_FRAGMENTATION_STORAGE_SIZE (1024*1024)
+#define BENCHMARK_LOOKUP_STORAGE_SIZE        (8*1024*1024)
+#define BENCHMARK_LOOKUP_ENTRY_MAX           1024
+#define BENCHMARK_FILE_MAX     56
+#define BENCHMARK_CHURN_COUNT  4000
+#define BENCHMARK_LOOKUP_COUNT 20000
+
+// unistd.h read() & write() clash with FAT32 driver, declare fork() directly
+pid_t fork(void);
+
+// RAM-backed storage, counting ATA command issued by driver
+uint8_t  *image_storage;
+uint8_t  *file_buffer;
+uint32_t storage_size;
+static struct {
+    uint32_t read_command;
+    uint32_t read_block;
+    uint32_t write_command;
+    uint32_t write_block;
+} disk_counter;
+
+void read_blocks(void *ptr, uint32_t logical_block_address, uint8_t block_count) {
+    disk_counter.read_command++;
+    disk_counter.read_block += block_count;
+    memcpy(ptr, image_storage + BLOCK_SIZE*logical_block_address, BLOCK_SIZE*block_count);
+}
+
+void write_blocks(const void *ptr, uint32_t logical_block_address, uint8_t block_count) {
+    disk_counter.write_command++;
+    disk_counter.write_block += block_count;
+    memcpy(image_storage + BLOCK_SIZE*logical_block_address, ptr, BLOCK_SIZE*block_count);
+}
+
+uint32_t disk_get_block_count(void) {
+    return storage_size / BLOCK_SIZE;
+}
+
+// No process on host, executable page is never cached
+void image_cache_invalidate(uint32_t first_cluster) {
+    (void) first_cluster;
+}
+
+
+
+// -- Fragmentation benchmark --
+static struct {
+    bool     live;
+    uint32_t size;
+    uint8_t  seed;
+} file_list[BENCHMARK_FILE_MAX];
+
+static struct FAT32DriverRequest file_request(uint32_t index, void *buf, uint32_t size) {
+    struct FAT32DriverRequest request = {
+        .buf                   = buf,
+        .ext                   = "bin",
+        .parent_cluster_number = ROOT_CLUSTER_NUMBER,
+        .buffer_size           = size,
+    };
+    snprintf(request.name, 8, "f%u", index);
+    return request;
+}
+
+static void file_create(uint32_t index, uint32_t cluster_count) {
+    uint32_t size = cluster_count*CLUSTER_SIZE - rand() % CLUSTER_SIZE;
+    uint8_t  seed = rand();
+    for (uint32_t i = 0; i < size; i++)
+        file_buffer[i] = seed + i;
+    if (write(file_request(index, file_buffer, size)) == 0) {
+        file_list[index].live = true;
+        file_list[index].size = size;
+        file_list[index].seed = seed;
+    }
+}
+
+static void file_delete(uint32_t index) {
+    delete(file_request(index, NULL, 0));
+    file_list[index].live = false;
+}
+
+// Read all files and print ATA command needed, ideal is single command per file
+static void report(const char *phase) {
+    uint32_t file_count       = 0;
+    uint32_t fragmented_count = 0;
+    uint32_t corrupted_count  = 0;
+    memset(&disk_counter, 0, sizeof(disk_counter));
+    for (uint32_t index = 0; index < BENCHMARK_FILE_MAX; index++) {
+        if (!file_list[index].live)
+            continue;
+        uint32_t command_before = disk_counter.read_command;
+        read(file_request(index, file_buffer, storage_size));
+        for (uint32_t i = 0; i < file_list[index].size; i++) {
+            if (file_buffer[i] != (uint8_t) (file_list[index].seed + i)) {
+                corrupted_count++;
+                break;
+            }
+        }
+        file_count++;
+        fragmented_count += disk_counter.read_command - command_before > 1;
+    }
+    printf("%-14s %6u %11u %10u %10u %9.2f %10u\n", phase, file_count, fragmented_count,
+        disk_counter.read_command, disk_counter.read_block, 
+        file_count ? (double) disk_counter.read_command / file_count : 0.0, corrupted_count);
+}
+
+static void benchmark_fragmentation(void) {
+    // Fill storage with small files then delete every other file, leaving free space full of holes
+    for (uint32_t index = 0; index < BENCHMARK_FILE_MAX; index++)
+        file_create(index, 1 + rand() % 8);
+    for (uint32_t index = 0; index < BENCHMARK_FILE_MAX; index += 2)
+        file_delete(index);
+
+    // Random create & delete churn with mixed file size
+    for (uint32_t i = 0; i < BENCHMARK_CHURN_COUNT; i++) {
+        uint32_t index = rand() % BENCHMARK_FILE_MAX;
+        if (file_list[index].live)
+            file_delete(index);
+        else
+            file_create(index, 1 + rand() % 24);
+    }
+
+    printf("%-14s %6s %11s %10s %10s %9s %10s\n", "phase", "files", "fragmented", "read cmd", "read block", "cmd/file", "corrupted");
+    report("after churn");
+    uint32_t relocated_count = defragment_all();
+    report("after defrag");
+    printf("defragment_all() relocated %u files\n", relocated_count);
+}
+
+
+
+
+// -- Directory lookup benchmark --
+static double elapsed_ns(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec)*1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+// Average driver_dir_table_lookup() cost of existing and missing name, name is prepared beforehand
+static void measure_lookup(uint32_t dir_cluster, uint32_t entry_count, double *hit_ns, double *miss_ns) {
+    static char name[2][BENCHMARK_LOOKUP_ENTRY_MAX][8];
+    char ext[3] = "bin";
+    for (uint32_t i = 0; i < entry_count; i++) {
+        memset(name[0][i], 0, 8);
+        memset(name[1][i], 0, 8);
+        snprintf(name[0][i], 8, "e%u", i);
+        snprintf(name[1][i], 8, "m%u", i);
+    }
+
+    double *result[2] = {hit_ns, miss_ns};
+    for (uint32_t kind = 0; kind < 2; kind++) {
+        struct timespec start, end;
+        uint32_t        found_count = 0;
+        uint32_t        entry_cluster;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (uint32_t i = 0; i < BENCHMARK_LOOKUP_COUNT; i++)
+            found_count += driver_dir_table_lookup(dir_cluster, name[kind][i % entry_count], ext, &entry_cluster) != -1;
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        *result[kind] = elapsed_ns(start, end) / BENCHMARK_LOOKUP_COUNT;
+        if (found_count != (kind == 0 ? BENCHMARK_LOOKUP_COUNT : 0))
+            printf("lookup mismatch: %u found\n", found_count);
+    }
+}
+
+static void benchmark_lookup(void) {
+    const uint32_t entry_count_list[] = {16, 62, 256, BENCHMARK_LOOKUP_ENTRY_MAX};
+    printf("%-8s %14s %14s %14s %14s\n", "entries", "scan hit ns", "scan miss ns", "index hit ns", "index miss ns");
+    for (uint32_t n = 0; n < sizeof(entry_count_list) / sizeof(entry_count_list[0]); n++) {
+        uint32_t entry_count = entry_count_list[n];
+
+        // Fresh directory filled with entry_count single byte files, directory grow into multiple cluster
+        struct FAT32DriverRequest dir_request = {
+            .ext                   = "\0\0\0",
+            .parent_cluster_number = ROOT_CLUSTER_NUMBER,
+            .buffer_size           = 0,
+        };
+        snprintf(dir_request.name, 8, "lk%u", entry_count);
+        write(dir_request);
+        struct FAT32DirectoryTable root_table;
+        uint32_t                   dir_cluster = 0;
+        read_clusters(&root_table, ROOT_CLUSTER_NUMBER, 1);
+        for (uint32_t i = 2; i < DIRECTORY_TABLE_ENTRY_COUNT; i++)
+            if (!memcmp(root_table.table[i].name, dir_request.name, 8))
+                dir_cluster = get_cluster_from_entry(root_table.table[i]);
+
+        for (uint32_t i = 0; i < entry_count; i++) {
+            struct FAT32DriverRequest request = file_request(0, file_buffer, 1);
+            request.parent_cluster_number     = dir_cluster;
+            snprintf(request.name, 8, "e%u", i);
+            write(request);
+        }
+
+        double scan_hit, scan_miss, index_hit, index_miss;
+        directory_index_set_enable(false);
+        measure_lookup(dir_cluster, entry_count, &scan_hit, &scan_miss);
+        directory_index_set_enable(true);
+        measure_lookup(dir_cluster, entry_count, &index_hit, &index_miss);
+        printf("%-8u %14.1f %14.1f %14.1f %14.1f\n", entry_count, scan_hit, scan_miss, index_hit, index_miss);
+
+        for (uint32_t i = 0; i < entry_count; i++) {
+            struct FAT32DriverRequest request = file_request(0, NULL, 0);
+            request.parent_cluster_number     = dir_cluster;
+            snprintf(request.name, 8, "e%u", i);
+            delete(request);
+        }
+        delete(dir_request);
+    }
+}
+
+// Run benchmark in child process, every benchmark start with fresh storage and driver state
+static void run_benchmark(const char *title, uint32_t size, void (*benchmark)(void)) {
+    puts(title);
+    fflush(stdout);
+    if (fork() == 0) {
+        storage_size  = size;
+        image_storage = calloc(storage_size, 1);
+        file_buffer   = malloc(storage_size);
+        initialize_filesystem_fat32();
+        benchmark();
+        exit(0);
+    }
+    wait(NULL);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int seed = 2024;
+    if (argc >= 2)
+        sscanf(argv[1], "%u", &seed);
+    srand(seed);
+
+    run_benchmark("-- Directory lookup benchmark --", BENCHMARK_LOOKUP_STORAGE_SIZE,        benchmark_lookup);
+    run_benchmark("-- Fragmentation benchmark --",    BENCHMARK_FRAGMENTATION_STORAGE_SIZE, benchmark_fragmentation);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "header/stdlib/string.h"
+#include "header/stdlib/string-benchmark.h"
+
+static const char *function_name[STRING_BENCHMARK_FUNCTION_COUNT] = {"memcpy", "memset", "memcmp", "memmove"};
+static const char *variant_name[STRING_BENCHMARK_VARIANT_COUNT]   = {"rep string", "SSE2"};
+
+int main(void) {
+    uint8_t *buffer = aligned_alloc(64, (STRING_BENCHMARK_BUFFER_SIZE + 63) & ~63);
+    struct StringBenchmarkResult result;
+    if (buffer == NULL)
+        return 1;
+
+    // Host FPU register is always usable, no begin & end callback needed
+    string_enable_sse2(NULL, NULL);
+    string_benchmark_run(buffer, &result);
+
+    for (uint32_t variant = 0; variant < result.variant_count; variant++) {
+        printf("-- %s, bytes per cycle --\n", variant_name[variant]);
+        printf("%-8s %7s %10s %10s %10s\n", "function", "size", "aligned", "offset 1", "dest +3");
+        for (uint32_t function = 0; function < STRING_BENCHMARK_FUNCTION_COUNT; function++) {
+            for (uint32_t size_index = 0; size_index < STRING_BENCHMARK_SIZE_COUNT; size_index++) {
+                printf("%-8s %7u", function_name[function], STRING_BENCHMARK_SIZE_MIN << (STRING_BENCHMARK_SIZE_SHIFT * size_index));
+                for (uint32_t align = 0; align < STRING_BENCHMARK_ALIGN_COUNT; align++) {
+                    uint32_t cycle = result.cycle[variant][function][size_index][align];
+                    printf(" %10.2f", cycle == 0 ? 0.0 : (double) STRING_BENCHMARK_CELL_BYTES / cycle);
+                }
+                printf("\n");
+            }
+        }
+    }
+    free(buffer);
+    return 0;
+}
@@ -0,0 +1,55 @@
+#ifndef _USER_LIB_H
+#define _USER_LIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Shared helper for user program, each program is single translation unit so helper is defined here.
+ * Helper that some program does not use is static inline to keep -Wunused-function quiet
+ */
+
+/**
+ * Kernel syscall through int 0x30, return value is written by kernel into pointer argument
+ *
+ * @param eax Syscall number
+ * @param ebx First argument
+ * @param ecx Second argument
+ * @param edx Third argument
+ */
+static void syscall(uint32_t eax, uint32_t ebx, uint32_t ecx, uint32_t edx) {
+    __asm__ volatile("mov %0, %%ebx" : /* <Empty> */ : "r"(ebx));
+    __asm__ volatile("mov %0, %%ecx" : /* <Empty> */ : "r"(ecx));
+    __asm__ volatile("mov %0, %%edx" : /* <Empty> */ : "r"(edx));
+    __asm__ volatile("mov %0, %%eax" : /* <Empty> */ : "r"(eax));
+    // Note : gcc usually use %eax as intermediate register,
+    //        so it need to be the last one to mov
+    __asm__ volatile("int $0x30");
+}
+
+static inline size_t strlen(const char *ptr) {
+    uint32_t i = 0;
+    while (ptr[i] != '\0')
+        i++;
+    return i;
+}
+
+// Print null-terminated string at cursor
+static inline void puts(const char *buf, uint8_t color) {
+    syscall(6, (uint32_t) buf, strlen(buf), color);
+}
+
+// Print unsigned decimal at cursor
+static inline void put_uint(uint32_t x, uint8_t color) {
+    char     buf[11];
+    uint32_t i = sizeof(buf) - 1;
+    buf[i] = '\0';
+    do {
+        buf[--i] = '0' + x % 10;
+        x       /= 10;
+    } while (x > 0);
+    puts(buf + i, color);
+}
+
+#endif
@@ -0,0 +1,49 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "header/cpu/clocksource.h"
+#include "external/user-lib.h"
+
+// Back to back clock read, whole run must stay below 4 second for 32-bit nanosecond delta
+#define CLOCKRES_ITERATION     1000
+#define SYSCALL_CLOCK_GETTIME  29
+
+static void clock_gettime(uint32_t clock_id, struct ClockTimespec *time) {
+    syscall(SYSCALL_CLOCK_GETTIME, clock_id, (uint32_t) time, 0);
+}
+
+static uint32_t elapsed_ns(struct ClockTimespec *start, struct ClockTimespec *end) {
+    return (end->second - start->second) * CLOCKSOURCE_NANOSECOND_PER_SEC + end->nanosecond - start->nanosecond;
+}
+
+int main(void) {
+    // Smallest nonzero step between consecutive read is the observable resolution
+    struct ClockTimespec start, previous, current;
+    uint32_t             resolution = 0xFFFFFFFF;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    previous = start;
+    for (uint32_t i = 0; i < CLOCKRES_ITERATION; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &current);
+        uint32_t step = elapsed_ns(&previous, &current);
+        if (step != 0 && step < resolution)
+            resolution = step;
+        previous = current;
+    }
+
+    puts("clockres: ", 0xF);
+    put_uint(elapsed_ns(&start, &current) / CLOCKRES_ITERATION, 0xF);
+    puts(" ns per call, resolution ", 0xF);
+    if (resolution == 0xFFFFFFFF)
+        puts("unknown", 0xF);
+    else
+        put_uint(resolution, 0xF);
+    puts(" ns\nmonotonic ", 0xF);
+    put_uint(current.second, 0xF);
+    puts(" s ", 0xF);
+    put_uint(current.nanosecond, 0xF);
+    clock_gettime(CLOCK_REALTIME, &current);
+    puts(" ns, realtime ", 0xF);
+    put_uint(current.second, 0xF);
+    puts(" s since epoch\n", 0xF);
+    syscall(10, 0, 0, 0);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "header/filesystem/fat32.h"
+#include "header/filesystem/file.h"
+#include "external/user-lib.h"
+
+// Two page of file-backed data, read as whole cluster run so disk driver may use DMA
+#define COWDMA_PAGE_SIZE   0x1000
+#define COWDMA_BUFFER_SIZE (2 * COWDMA_PAGE_SIZE)
+#define COWDMA_PATTERN     0xA5
+
+// Initialized data live in executable image, page is mapped shared copy-on-write from image cache
+__attribute__((aligned(COWDMA_PAGE_SIZE)))
+static uint8_t buffer[COWDMA_BUFFER_SIZE] = {[0 ... COWDMA_BUFFER_SIZE - 1] = COWDMA_PATTERN};
+
+// Read own executable over the whole buffer, executable is larger than buffer
+static void read_into_buffer(void) {
+    struct FAT32DriverRequest request = {
+        .name                  = "cowdma\0\0",
+        .ext                   = "\0\0\0",
+        .parent_cluster_number = ROOT_CLUSTER_NUMBER,
+    };
+    int32_t fd;
+    syscall(14, (uint32_t) &request, FILE_MODE_READ, (uint32_t) &fd);
+    if (fd < 0)
+        return;
+
+    int32_t            read_size;
+    int8_t             retcode;
+    struct FileRequest file_request = {
+        .fd   = fd,
+        .buf  = buffer,
+        .size = COWDMA_BUFFER_SIZE,
+    };
+    syscall(15, (uint32_t) &file_request, (uint32_t) &read_size, 0);
+    syscall(18, fd, (uint32_t) &retcode, 0);
+}
+
+int main(void) {
+    // First page is shared with child through fork, second page is only shared through image cache
+    volatile uint8_t first = buffer[0];
+    (void) first;
+
+    volatile int32_t pid;
+    syscall(21, (uint32_t) &pid, 0, 0);
+    if (pid == 0) {
+        read_into_buffer();
+        syscall(10, 0, 0, 0);
+    }
+    if (pid < 0) {
+        puts("cowdma: fork failed\n", 0xC);
+        syscall(10, 0, 0, 0);
+    }
+    syscall(25, pid, 0, 0);
+
+    // Child read must stay private, neither parent frame nor cached image page may change
+    bool intact = true;
+    for (uint32_t i = 0; i < COWDMA_BUFFER_SIZE; i++)
+        if (buffer[i] != COWDMA_PATTERN)
+            intact = false;
+    puts("cowdma: ", 0xF);
+    if (intact)
+        puts("ok\n", 0xA);
+    else
+        puts("CORRUPT\n", 0xC);
+    syscall(10, 0, 0, 0);
+    return 0;
+}
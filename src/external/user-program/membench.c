@@ -0,0 +1,46 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "header/stdlib/string-benchmark.h"
+#include "external/user-lib.h"
+
+#define SYSCALL_STRING_BENCHMARK 27
+
+static const char *function_name[STRING_BENCHMARK_FUNCTION_COUNT] = {"memcpy  ", "memset  ", "memcmp  ", "memmove "};
+
+// Bytes per cycle with 2 decimal digit, cell always process STRING_BENCHMARK_CELL_BYTES
+static void put_throughput(uint32_t cycle, uint8_t color) {
+    uint32_t hundredth = cycle == 0 ? 0 : (100u * STRING_BENCHMARK_CELL_BYTES) / cycle;
+    puts(" ", color);
+    put_uint(hundredth / 100, color);
+    puts(hundredth % 100 < 10 ? ".0" : ".", color);
+    put_uint(hundredth % 100, color);
+}
+
+int main(void) {
+    struct StringBenchmarkResult result;
+    syscall(SYSCALL_STRING_BENCHMARK, (uint32_t) &result, 0, 0);
+    if (result.variant_count == 0) {
+        puts("membench: out of memory\n", 0xC);
+        syscall(10, 0, 0, 0);
+    }
+
+    // Column: rep string aligned, offset 1, dest +3, then SSE2 in same order
+    puts("membench: bytes per cycle, rep string", 0xF);
+    puts(result.variant_count > 1 ? " | SSE2\n" : "\n", 0xF);
+    for (uint32_t function = 0; function < STRING_BENCHMARK_FUNCTION_COUNT; function++) {
+        for (uint32_t size_index = 0; size_index < STRING_BENCHMARK_SIZE_COUNT; size_index++) {
+            puts(function_name[function], 0x7);
+            put_uint(STRING_BENCHMARK_SIZE_MIN << (STRING_BENCHMARK_SIZE_SHIFT * size_index), 0x7);
+            puts(":", 0x7);
+            for (uint32_t variant = 0; variant < result.variant_count; variant++) {
+                if (variant > 0)
+                    puts(" |", 0x7);
+                for (uint32_t align = 0; align < STRING_BENCHMARK_ALIGN_COUNT; align++)
+                    put_throughput(result.cycle[variant][function][size_index][align], 0xF);
+            }
+            puts("\n", 0xF);
+        }
+    }
+    syscall(10, 0, 0, 0);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "header/memory/frame-allocator.h"
+#include "external/user-lib.h"
+
+// Process spawned & reaped, every child touch its stack so copy-on-write frame is allocated
+#define SPAWN_ITERATION 4096
+
+// Fork child that exit right away then wait for it - @return False if fork failed
+static bool spawn_and_reap(void) {
+    volatile int32_t pid;
+    syscall(21, (uint32_t) &pid, 0, 0);
+    if (pid == 0)
+        syscall(10, 0, 0, 0); // Child write into shared stack page then exit
+    if (pid < 0)
+        return false;
+    syscall(25, pid, 0, 0);
+    return true;
+}
+
+int main(void) {
+    // Warm up, first spawn may grow process table & PCB slab that is kept for reuse
+    struct FrameAllocatorStatistic before, after;
+    spawn_and_reap();
+    syscall(19, (uint32_t) &before, 0, 0);
+
+    uint32_t spawned = 0;
+    while (spawned < SPAWN_ITERATION && spawn_and_reap())
+        spawned++;
+
+    syscall(19, (uint32_t) &after, 0, 0);
+    puts("spawn: ", 0xF);
+    put_uint(spawned, 0xF);
+    puts(" process reaped, free frame ", 0xF);
+    put_uint(before.free_frame, 0xF);
+    puts(" -> ", 0xF);
+    put_uint(after.free_frame, 0xF);
+    if (spawned == SPAWN_ITERATION && after.free_frame == before.free_frame)
+        puts(" ok\n", 0xA);
+    else
+        puts(" LEAK\n", 0xC);
+    syscall(10, 0, 0, 0);
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "external/user-lib.h"
+
+// Null syscall round trip count, power of two so average is computed with shift
+#define SYSBENCH_ITERATION_SHIFT 16
+#define SYSBENCH_ITERATION       (1u << SYSBENCH_ITERATION_SHIFT)
+#define SYSCALL_NULL             26
+
+// Same register convention as int 0x30, kernel return into label after sysenter with saved esp
+void syscall_sysenter(uint32_t eax, uint32_t ebx, uint32_t ecx, uint32_t edx) {
+    __asm__ volatile(
+        "mov  %%esp, %%edi\n"
+        "mov  $1f, %%esi\n"
+        "sysenter\n"
+        "1:\n"
+        : "+a"(eax), "+b"(ebx), "+c"(ecx), "+d"(edx)
+        : /* <Empty> */
+        : "esi", "edi", "memory"
+    );
+}
+
+static uint64_t rdtsc(void) {
+    uint32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t) high << 32) | low;
+}
+
+// Average cycle per null syscall round trip - @param fast Use sysenter instead of int 0x30
+static uint32_t measure(bool fast) {
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < SYSBENCH_ITERATION; i++) {
+        if (fast)
+            syscall_sysenter(SYSCALL_NULL, 0, 0, 0);
+        else
+            syscall(SYSCALL_NULL, 0, 0, 0);
+    }
+    return (uint32_t) ((rdtsc() - start) >> SYSBENCH_ITERATION_SHIFT);
+}
+
+int main(void) {
+    // Warm up both path so first measurement does not pay for demand paging
+    measure(false);
+    measure(true);
+
+    puts("sysbench: int 0x30 ", 0xF);
+    put_uint(measure(false), 0xF);
+    puts(" cycle, sysenter ", 0xF);
+    put_uint(measure(true), 0xF);
+    puts(" cycle per null syscall\n", 0xF);
+    syscall(10, 0, 0, 0);
+    return 0;
+}
@@ -0,0 +1,25 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "header/cpu/apic.h"
+#include "external/user-lib.h"
+
+// Measurement window, caller sleep so mostly-idle system is measured
+#define TICKSTAT_WINDOW_MS     1000
+#define SYSCALL_SLEEP           24
+#define SYSCALL_TIMER_STATISTIC 28
+
+int main(void) {
+    struct TimerStatistic before, after;
+    syscall(SYSCALL_TIMER_STATISTIC, (uint32_t) &before, 0, 0);
+    syscall(SYSCALL_SLEEP, TICKSTAT_WINDOW_MS, 0, 0);
+    syscall(SYSCALL_TIMER_STATISTIC, (uint32_t) &after, 0, 0);
+
+    puts("tickstat: ", 0xF);
+    puts(after.tickless ? "tickless local APIC, " : "periodic PIT, ", 0xF);
+    put_uint(after.interrupt_count - before.interrupt_count, 0xF);
+    puts(" timer interrupt in ", 0xF);
+    put_uint(after.clock_tick - before.clock_tick, 0xF);
+    puts(" tick\n", 0xF);
+    syscall(10, 0, 0, 0);
+    return 0;
+}
@@ -1,39 +1,46 @@
 #include <stdint.h>
 #include "header/filesystem/fat32.h"
+#include "header/filesystem/file.h"
+#include "external/user-lib.h"
 
-void syscall(uint32_t eax, uint32_t ebx, uint32_t ecx, uint32_t edx) {
-    __asm__ volatile("mov %0, %%ebx" : /* <Empty> */ : "r"(ebx));
-    __asm__ volatile("mov %0, %%ecx" : /* <Empty> */ : "r"(ecx));
-    __asm__ volatile("mov %0, %%edx" : /* <Empty> */ : "r"(edx));
-    __asm__ volatile("mov %0, %%eax" : /* <Empty> */ : "r"(eax));
-    // Note : gcc usually use %eax as intermediate register,
-    //        so it need to be the last one to mov
-    __asm__ volatile("int $0x30");
-}
+/**
+ * Program launched by typing its name, file in root directory with the same name
+ *
+ * @param name            Command & file name, at most 8 character
+ * @param buffer_size     Largest accepted executable size
+ * @param started_message Printed after process is created, NULL for none
+ */
+struct ShellProgram {
+    const char *name;
+    uint32_t   buffer_size;
+    const char *started_message;
+};
+
+static const struct ShellProgram shell_program[] = {
+    {"clock",    CLUSTER_SIZE,     "Clock running..\n"},
+    {"spawn",    CLUSTER_SIZE,     NULL}, // Process teardown stress test, report free page frame before & after
+    {"sysbench", CLUSTER_SIZE,     NULL}, // Null syscall round trip benchmark, int 0x30 against sysenter
+    {"membench", CLUSTER_SIZE,     NULL}, // Kernel memcpy, memset, memcmp & memmove throughput table
+    {"tickstat", CLUSTER_SIZE,     NULL}, // Timer interrupt count over one second of sleep
+    {"clockres", CLUSTER_SIZE,     NULL}, // clock_gettime() call cost and current monotonic & wall-clock time
+    {"cowdma",   8 * CLUSTER_SIZE, NULL}, // Disk read into copy-on-write page after fork, two page of initialized data
+};
 
-void init_clock(void) {
+// Create process from executable in root directory - @return process_create() return code, 0 on success
+int32_t exec(const char *name, uint32_t size) {
     struct FAT32DriverRequest request = {
         .buf                   = (uint8_t*) 0,
-        .name                  = "clock\0\0\0",
+        .name                  = "\0\0\0\0\0\0\0\0",
         .ext                   = "\0\0\0",
         .parent_cluster_number = ROOT_CLUSTER_NUMBER,
-        .buffer_size           = CLUSTER_SIZE,
+        .buffer_size           = size,
     };
-    int retcode = 0;
-    syscall(8, (uint32_t) &request, (uint32_t) &retcode, 0);
-    if (retcode == 0)
-        syscall(6, (uint32_t) "Clock running..\n", 17, 0xF);
-}
+    for (uint32_t i = 0; i < 8 && name[i] != '\0'; i++)
+        request.name[i] = name[i];
 
-size_t strlen(const char *ptr) {
-    uint32_t i = 0;
-    while (ptr[i] != '\0')
-        i++;
-    return i;
-}
-
-void puts(char *buf, uint8_t color) {
-    syscall(6, (uint32_t) buf, strlen(buf), color);
+    int32_t retcode = 0;
+    syscall(8, (uint32_t) &request, (uint32_t) &retcode, 0);
+    return retcode;
 }
 
 #define BIOS_BLACK         0x0
@@ -84,6 +91,41 @@ uint8_t strcmp(const char *a, const char *b) {
     }
 }
 
+// Stream file in root directory into screen with small buffer
+void cat(char *name) {
+    struct FAT32DriverRequest request = {
+        .name                  = "\0\0\0\0\0\0\0\0",
+        .ext                   = "\0\0\0",
+        .parent_cluster_number = ROOT_CLUSTER_NUMBER,
+    };
+    for (uint32_t i = 0; i < 8 && name[i] != '\0'; i++)
+        request.name[i] = name[i];
+
+    int32_t fd;
+    syscall(14, (uint32_t) &request, FILE_MODE_READ, (uint32_t) &fd);
+    if (fd < 0) {
+        puts("cat: file not found\n", BIOS_LIGHT_RED);
+        return;
+    }
+
+    char buf[256];
+    int32_t read_size;
+    struct FileRequest file_request = {
+        .fd   = fd,
+        .buf  = buf,
+        .size = sizeof(buf),
+    };
+    do {
+        syscall(15, (uint32_t) &file_request, (uint32_t) &read_size, 0);
+        if (read_size > 0)
+            syscall(6, (uint32_t) buf, read_size, BIOS_GRAY);
+    } while (read_size > 0);
+    puts("\n", BIOS_GRAY);
+
+    int8_t retcode;
+    syscall(18, fd, (uint32_t) &retcode, 0);
+}
+
 int main(void) {
     syscall(7, 0, 0, 0);
     char buf[16];
@@ -95,8 +137,17 @@ int main(void) {
         fgets(buf, 16);
         if (!strcmp(buf, "ls")) {
             puts("\n", BIOS_BLACK);
-        } else if (!strcmp(buf, "clock")) {
-            init_clock();
+        } else if (buf[0] == 'c' && buf[1] == 'a' && buf[2] == 't' && buf[3] == ' ') {
+            cat(buf + 4);
+        } else {
+            for (uint32_t i = 0; i < sizeof(shell_program) / sizeof(shell_program[0]); i++) {
+                const struct ShellProgram *program = &shell_program[i];
+                if (strcmp(buf, program->name))
+                    continue;
+                if (exec(program->name, program->buffer_size) == 0 && program->started_message != NULL)
+                    puts(program->started_message, BIOS_WHITE);
+                break;
+            }
         }
     }
 
@@ -1,6 +1,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "header/filesystem/fat32.h"
+#include "header/filesystem/buffer-cache.h"
+#include "header/filesystem/directory-index.h"
+#include "header/filesystem/image-cache.h"
 #include "header/stdlib/string.h"
 
 static struct FAT32DriverState fat32driver_state = {0};
@@ -22,16 +25,83 @@ static inline int32_t ceil_div(int32_t a, int32_t b) {
     return a / b + (a % b != 0);
 }
 
+static inline bool is_cluster_free(uint32_t cluster_number) {
+    return fat32driver_state.free_cluster_bitmap[cluster_number / 32] & (1u << (cluster_number % 32));
+}
+
+// FAT cluster 0 live in FAT_CLUSTER_NUMBER, the rest is placed right after root directory
+static uint32_t driver_fat_location(uint32_t fat_cluster_index) {
+    if (fat_cluster_index == 0)
+        return FAT_CLUSTER_NUMBER;
+    return ROOT_CLUSTER_NUMBER + fat_cluster_index;
+}
+
+uint32_t driver_fat_get_entry(uint32_t cluster_number) {
+    uint32_t *fat_cluster = buffer_cache_get(driver_fat_location(cluster_number / CLUSTER_MAP_SIZE));
+    return fat_cluster[cluster_number % CLUSTER_MAP_SIZE];
+}
+
+void driver_fat_set_entry(uint32_t cluster_number, uint32_t value) {
+    uint32_t  fat_cluster_number = driver_fat_location(cluster_number / CLUSTER_MAP_SIZE);
+    uint32_t  entry_offset       = cluster_number % CLUSTER_MAP_SIZE;
+    uint32_t *fat_cluster        = buffer_cache_get(fat_cluster_number);
+    fat_cluster[entry_offset]    = value;
+    // Only single FAT block is dirty
+    buffer_cache_mark_dirty(fat_cluster_number, entry_offset * sizeof(uint32_t), sizeof(uint32_t));
+
+    // Keep free cluster bitmap in sync
+    bool was_free = is_cluster_free(cluster_number);
+    bool is_free  = value == FAT32_FAT_EMPTY_ENTRY;
+    if (is_free)
+        fat32driver_state.free_cluster_bitmap[cluster_number / 32] |= 1u << (cluster_number % 32);
+    else
+        fat32driver_state.free_cluster_bitmap[cluster_number / 32] &= ~(1u << (cluster_number % 32));
+    fat32driver_state.free_cluster_count += (int32_t) is_free - (int32_t) was_free;
+}
+
+static void driver_fat_build_free_bitmap(void) {
+    memset(fat32driver_state.free_cluster_bitmap, 0, sizeof(fat32driver_state.free_cluster_bitmap));
+    fat32driver_state.free_cluster_count = 0;
+    for (uint32_t fat_index = 0; fat_index < fat32driver_state.fat_cluster_count; fat_index++) {
+        // Single pass over whole FAT, one cluster at a time
+        struct FAT32FileAllocationTable *fat_cluster = (struct FAT32FileAllocationTable*) &fat32driver_state.cluster_buf;
+        read_clusters(fat_cluster, driver_fat_location(fat_index), 1);
+        for (uint32_t j = 0; j < CLUSTER_MAP_SIZE; j++) {
+            uint32_t i = fat_index*CLUSTER_MAP_SIZE + j;
+            if (i < fat32driver_state.cluster_count && fat_cluster->cluster_map[j] == FAT32_FAT_EMPTY_ENTRY) {
+                fat32driver_state.free_cluster_bitmap[i / 32] |= 1u << (i % 32);
+                fat32driver_state.free_cluster_count++;
+            }
+        }
+    }
+}
+
 uint32_t cluster_to_lba(uint32_t cluster_number) {
     return cluster_number * CLUSTER_BLOCK_COUNT;
 }
 
 void write_clusters(const void *ptr, uint32_t cluster_number, uint8_t cluster_count) {
+    if (cluster_count == 1) {
+        buffer_cache_write(ptr, cluster_number);
+        return;
+    }
+
+    // Multi-cluster write bypass the cache with single command, keep cached copies coherent
     write_blocks(ptr, cluster_to_lba(cluster_number), cluster_count*CLUSTER_BLOCK_COUNT);
+    for (uint32_t i = 0; i < cluster_count; i++)
+        buffer_cache_refresh((uint8_t*) ptr + CLUSTER_SIZE*i, cluster_number + i);
 }
 
 void read_clusters(void *ptr, uint32_t cluster_number, uint8_t cluster_count) {
+    if (cluster_count == 1) {
+        buffer_cache_read(ptr, cluster_number);
+        return;
+    }
+
+    // Multi-cluster read bypass the cache with single command, cached dirty clusters is newer than disk
     read_blocks(ptr, cluster_to_lba(cluster_number), cluster_count*CLUSTER_BLOCK_COUNT);
+    for (uint32_t i = 0; i < cluster_count; i++)
+        buffer_cache_overlay_dirty((uint8_t*) ptr + CLUSTER_SIZE*i, cluster_number + i);
 }
 
 void init_directory_table(struct FAT32DirectoryTable *dir_table, char *name, uint32_t parent_dir_cluster) {
@@ -54,21 +124,59 @@ void init_directory_table(struct FAT32DirectoryTable *dir_table, char *name, uin
 bool is_empty_storage(void) {
     struct BlockBuffer boot_sector;
     read_blocks(&boot_sector, 0, 1);
-    return memcmp(&boot_sector, fs_signature, BLOCK_SIZE);
+    // Geometry is not part of signature
+    bool is_signature_before_geometry_equal = !memcmp(&boot_sector, fs_signature, FS_GEOMETRY_OFFSET);
+    bool is_signature_after_geometry_equal  = !memcmp(
+        boot_sector.buf + FS_GEOMETRY_OFFSET + sizeof(struct FAT32Geometry), 
+        fs_signature    + FS_GEOMETRY_OFFSET + sizeof(struct FAT32Geometry), 
+        BLOCK_SIZE - FS_GEOMETRY_OFFSET - sizeof(struct FAT32Geometry)
+    );
+    return !is_signature_before_geometry_equal || !is_signature_after_geometry_equal;
 }
 
-void create_fat32(void) {
-    write_blocks(fs_signature, BOOT_SECTOR, 1);
+static void driver_set_geometry(struct FAT32Geometry geometry) {
+    // Zeroed geometry is file system created before multi-cluster FAT
+    if (geometry.cluster_count == 0) {
+        geometry.cluster_count     = CLUSTER_MAP_SIZE;
+        geometry.fat_cluster_count = 1;
+    }
+    if (geometry.cluster_count > FAT32_CLUSTER_COUNT_MAX)
+        geometry.cluster_count = FAT32_CLUSTER_COUNT_MAX;
+    fat32driver_state.cluster_count     = geometry.cluster_count;
+    fat32driver_state.fat_cluster_count = geometry.fat_cluster_count;
+}
 
-    // Reserved values
-    fat32driver_state.fat_table.cluster_map[0] = CLUSTER_0_VALUE;
-    fat32driver_state.fat_table.cluster_map[1] = CLUSTER_1_VALUE;
+void create_fat32(void) {
+    // Derive FAT size from disk size, FAT cluster k > 0 is placed at ROOT_CLUSTER_NUMBER + k
+    struct FAT32Geometry geometry = {
+        .cluster_count = disk_get_block_count() / CLUSTER_BLOCK_COUNT,
+    };
+    if (geometry.cluster_count > FAT32_CLUSTER_COUNT_MAX)
+        geometry.cluster_count = FAT32_CLUSTER_COUNT_MAX;
+    if (geometry.cluster_count > 0) {
+        geometry.fat_cluster_count = ceil_div(geometry.cluster_count, CLUSTER_MAP_SIZE);
+        if (geometry.cluster_count < ROOT_CLUSTER_NUMBER + geometry.fat_cluster_count)
+            geometry.cluster_count = 0;
+    }
+    driver_set_geometry(geometry);
 
-    // Root
-    fat32driver_state.fat_table.cluster_map[ROOT_CLUSTER_NUMBER] = FAT32_FAT_END_OF_FILE;
-    
-    // Write new valid File Allocation Table
-    write_clusters(&fat32driver_state.fat_table, FAT_CLUSTER_NUMBER, 1);
+    struct BlockBuffer boot_sector;
+    memcpy(&boot_sector, fs_signature, BLOCK_SIZE);
+    memcpy(boot_sector.buf + FS_GEOMETRY_OFFSET, &geometry, sizeof(struct FAT32Geometry));
+    write_blocks(&boot_sector, BOOT_SECTOR, 1);
+
+    // Write empty File Allocation Table
+    memset(&fat32driver_state.cluster_buf, 0, CLUSTER_SIZE);
+    for (uint32_t i = 0; i < fat32driver_state.fat_cluster_count; i++)
+        write_clusters(&fat32driver_state.cluster_buf, driver_fat_location(i), 1);
+    driver_fat_build_free_bitmap();
+
+    // Reserved values, FAT clusters, and root
+    driver_fat_set_entry(0, CLUSTER_0_VALUE);
+    driver_fat_set_entry(1, CLUSTER_1_VALUE);
+    for (uint32_t i = 1; i < fat32driver_state.fat_cluster_count; i++)
+        driver_fat_set_entry(driver_fat_location(i), FAT32_FAT_END_OF_FILE);
+    driver_fat_set_entry(ROOT_CLUSTER_NUMBER, FAT32_FAT_END_OF_FILE);
 
     // Write root directory table
     struct FAT32DirectoryTable root_dir_table = {0};
@@ -77,10 +185,17 @@ void create_fat32(void) {
 }
 
 void initialize_filesystem_fat32(void) {
-    if (is_empty_storage())
+    directory_index_reset();
+    if (is_empty_storage()) {
         create_fat32();
-    else
-        read_clusters(&fat32driver_state.fat_table, FAT_CLUSTER_NUMBER, 1);
+    } else {
+        struct BlockBuffer   boot_sector;
+        struct FAT32Geometry geometry;
+        read_blocks(&boot_sector, BOOT_SECTOR, 1);
+        memcpy(&geometry, boot_sector.buf + FS_GEOMETRY_OFFSET, sizeof(struct FAT32Geometry));
+        driver_set_geometry(geometry);
+        driver_fat_build_free_bitmap();
+    }
 }
 
 
@@ -94,25 +209,192 @@ uint32_t get_cluster_from_entry(struct FAT32DirectoryEntry entry) {
     return entry.cluster_high << 16 | entry.cluster_low;
 }
 
-int32_t driver_dir_table_linear_scan(char name[8], char ext[3], bool find_empty) {
-    for (uint32_t i = 0; i < DIRECTORY_TABLE_ENTRY_COUNT; i++) {
-        struct FAT32DirectoryEntry entry = fat32driver_state.dir_table_buf.table[i];
-        bool is_entry_not_empty          = (entry.user_attribute & UATTR_NOT_EMPTY);
-        bool search_and_found_empty      = find_empty && !is_entry_not_empty;
-        bool name_match                  = is_entry_not_empty && !memcmp(entry.name, name, 8) && !memcmp(entry.ext, ext, 3);
-        if (search_and_found_empty || name_match)
-            return i;
-    }
+// Load directory cluster holding entry_index into dir_table_buf, return FAT32_FAT_END_OF_FILE if chain is shorter
+static uint32_t driver_dir_load_entry_cluster(uint32_t dir_cluster, uint32_t entry_index) {
+    uint32_t cluster_iterator = dir_cluster;
+    for (uint32_t i = 0; i < entry_index / DIRECTORY_TABLE_ENTRY_COUNT && cluster_iterator != FAT32_FAT_END_OF_FILE; i++)
+        cluster_iterator = driver_fat_get_entry(cluster_iterator);
+    if (cluster_iterator != FAT32_FAT_END_OF_FILE)
+        read_clusters(&fat32driver_state.dir_table_buf, cluster_iterator, 1);
+    return cluster_iterator;
+}
+
+int32_t driver_dir_table_linear_scan(uint32_t dir_cluster, char name[8], char ext[3], uint32_t *entry_cluster) {
+    uint32_t entry_offset     = 0;
+    uint32_t cluster_iterator = dir_cluster;
+    do {
+        read_clusters(&fat32driver_state.dir_table_buf, cluster_iterator, 1);
+        for (uint32_t i = 0; i < DIRECTORY_TABLE_ENTRY_COUNT; i++) {
+            struct FAT32DirectoryEntry *entry = &fat32driver_state.dir_table_buf.table[i];
+            bool is_entry_not_empty           = (entry->user_attribute & UATTR_NOT_EMPTY);
+            if (is_entry_not_empty && !memcmp(entry->name, name, 8) && !memcmp(entry->ext, ext, 3)) {
+                *entry_cluster = cluster_iterator;
+                return entry_offset + i;
+            }
+        }
+        cluster_iterator = driver_fat_get_entry(cluster_iterator);
+        entry_offset    += DIRECTORY_TABLE_ENTRY_COUNT;
+    } while (cluster_iterator != FAT32_FAT_END_OF_FILE);
     return -1;
 }
 
+// Build directory index by walking whole directory chain on first access
+static bool driver_dir_index_load(uint32_t dir_cluster) {
+    if (directory_index_is_loaded(dir_cluster))
+        return true;
+    if (!directory_index_begin(dir_cluster))
+        return false;
+
+    uint32_t entry_offset     = 0;
+    uint32_t cluster_iterator = dir_cluster;
+    do {
+        read_clusters(&fat32driver_state.dir_table_buf, cluster_iterator, 1);
+        for (uint32_t i = 0; i < DIRECTORY_TABLE_ENTRY_COUNT; i++) {
+            struct FAT32DirectoryEntry *entry = &fat32driver_state.dir_table_buf.table[i];
+            if ((entry->user_attribute & UATTR_NOT_EMPTY) && !directory_index_insert(dir_cluster, entry->name, entry->ext, entry_offset + i))
+                return false;
+        }
+        cluster_iterator = driver_fat_get_entry(cluster_iterator);
+        entry_offset    += DIRECTORY_TABLE_ENTRY_COUNT;
+    } while (cluster_iterator != FAT32_FAT_END_OF_FILE);
+    return true;
+}
+
+int32_t driver_dir_table_lookup(uint32_t dir_cluster, char name[8], char ext[3], uint32_t *entry_cluster) {
+    if (!driver_dir_index_load(dir_cluster))
+        return driver_dir_table_linear_scan(dir_cluster, name, ext, entry_cluster);
+
+    int32_t entry_index = directory_index_lookup(dir_cluster, name, ext);
+    if (entry_index != -1)
+        *entry_cluster = driver_dir_load_entry_cluster(dir_cluster, entry_index);
+    return entry_index;
+}
+
+int32_t driver_dir_table_find_empty(uint32_t dir_cluster, uint32_t *entry_cluster) {
+    // Entries below free hint are known to be not empty
+    uint32_t search_start     = 0;
+    uint32_t entry_offset     = 0;
+    uint32_t last_cluster     = dir_cluster;
+    uint32_t cluster_iterator = dir_cluster;
+    if (driver_dir_index_load(dir_cluster))
+        search_start = directory_index_get_free_hint(dir_cluster);
+
+    do {
+        if (entry_offset + DIRECTORY_TABLE_ENTRY_COUNT > search_start) {
+            read_clusters(&fat32driver_state.dir_table_buf, cluster_iterator, 1);
+            uint32_t i = search_start > entry_offset ? search_start - entry_offset : 0;
+            for (; i < DIRECTORY_TABLE_ENTRY_COUNT; i++) {
+                if (!(fat32driver_state.dir_table_buf.table[i].user_attribute & UATTR_NOT_EMPTY)) {
+                    directory_index_set_free_hint(dir_cluster, entry_offset + i);
+                    *entry_cluster = cluster_iterator;
+                    return entry_offset + i;
+                }
+            }
+        }
+        last_cluster     = cluster_iterator;
+        cluster_iterator = driver_fat_get_entry(cluster_iterator);
+        entry_offset    += DIRECTORY_TABLE_ENTRY_COUNT;
+    } while (cluster_iterator != FAT32_FAT_END_OF_FILE);
+
+    // Directory is full, grow chain with single empty cluster
+    uint32_t new_cluster;
+    if (!driver_fat_find_contiguous_cluster(1, &new_cluster))
+        return -1;
+    driver_fat_set_entry(new_cluster,  FAT32_FAT_END_OF_FILE);
+    driver_fat_set_entry(last_cluster, new_cluster);
+    memset(&fat32driver_state.dir_table_buf, 0, sizeof(struct FAT32DirectoryTable));
+    write_clusters(&fat32driver_state.dir_table_buf, new_cluster, 1);
+
+    directory_index_set_free_hint(dir_cluster, entry_offset);
+    *entry_cluster = new_cluster;
+    return entry_offset;
+}
+
+// Check whole directory chain, skipping self and parent entry
+static bool driver_dir_is_empty(uint32_t dir_cluster) {
+    struct FAT32DirectoryTable dirtable;
+    read_clusters(&dirtable, dir_cluster, 1);
+    if (!is_dirtable_empty(&dirtable))
+        return false;
+
+    for (uint32_t iter = driver_fat_get_entry(dir_cluster); iter != FAT32_FAT_END_OF_FILE; iter = driver_fat_get_entry(iter)) {
+        read_clusters(&dirtable, iter, 1);
+        for (uint32_t i = 0; i < DIRECTORY_TABLE_ENTRY_COUNT; i++)
+            if (dirtable.table[i].user_attribute & UATTR_NOT_EMPTY)
+                return false;
+    }
+    return true;
+}
+
+// Free empty clusters at the end of directory chain, first cluster is always kept
+static void driver_dir_shrink(uint32_t dir_cluster) {
+    while (true) {
+        uint32_t previous_cluster = dir_cluster;
+        uint32_t last_cluster     = driver_fat_get_entry(dir_cluster);
+        if (last_cluster == FAT32_FAT_END_OF_FILE)
+            return;
+        while (driver_fat_get_entry(last_cluster) != FAT32_FAT_END_OF_FILE) {
+            previous_cluster = last_cluster;
+            last_cluster     = driver_fat_get_entry(last_cluster);
+        }
+
+        struct FAT32DirectoryTable *dirtable = buffer_cache_get(last_cluster);
+        for (uint32_t i = 0; i < DIRECTORY_TABLE_ENTRY_COUNT; i++)
+            if (dirtable->table[i].user_attribute & UATTR_NOT_EMPTY)
+                return;
+        driver_fat_set_entry(previous_cluster, FAT32_FAT_END_OF_FILE);
+        driver_fat_set_entry(last_cluster,     FAT32_FAT_EMPTY_ENTRY);
+    }
+}
+
+bool driver_fat_find_contiguous_cluster(uint32_t cluster_count, uint32_t *start_cluster) {
+    uint32_t best_start  = 0;
+    uint32_t best_length = 0;
+    uint32_t i           = 0;
+    while (i < fat32driver_state.cluster_count) {
+        // Skip 32 used clusters at once
+        if (i % 32 == 0 && fat32driver_state.free_cluster_bitmap[i / 32] == 0) {
+            i += 32;
+            continue;
+        } else if (!is_cluster_free(i)) {
+            i++;
+            continue;
+        }
+
+        // Best-fit: smallest free extent that can hold all clusters
+        uint32_t extent_start = i;
+        while (i < fat32driver_state.cluster_count && is_cluster_free(i))
+            i++;
+        uint32_t extent_length = i - extent_start;
+        if (extent_length >= cluster_count && (best_length == 0 || extent_length < best_length)) {
+            best_start  = extent_start;
+            best_length = extent_length;
+            if (extent_length == cluster_count)
+                break;
+        }
+    }
+
+    *start_cluster = best_start;
+    return best_length != 0;
+}
+
 int8_t driver_fat_mark_empty_cluster(uint32_t empty_buf[CLUSTER_MARK_MAX], uint32_t cluster_count) {
+    if (cluster_count > CLUSTER_MARK_MAX || cluster_count > fat32driver_state.free_cluster_count)
+        return -1;
+
+    // Prefer single contiguous extent
+    uint32_t start_cluster;
+    if (driver_fat_find_contiguous_cluster(cluster_count, &start_cluster)) {
+        for (uint32_t i = 0; i < cluster_count; i++)
+            empty_buf[i] = start_cluster + i;
+        return 0;
+    }
+
+    // Free space is too fragmented, fallback to first free clusters
     uint32_t marked_cluster_count = 0;
-    for (int i = 0; i < CLUSTER_MAP_SIZE && marked_cluster_count < CLUSTER_MARK_MAX; i++) {
-        uint32_t cluster = fat32driver_state.fat_table.cluster_map[i];
-        if (cluster == FAT32_FAT_EMPTY_ENTRY)
+    for (uint32_t i = 0; i < fat32driver_state.cluster_count && marked_cluster_count < cluster_count; i++)
+        if (is_cluster_free(i))
             empty_buf[marked_cluster_count++] = i;
-    }
 
     if (marked_cluster_count < cluster_count)
         return -1;
@@ -129,6 +411,36 @@ bool is_dirtable_empty(struct FAT32DirectoryTable *dirtable) {
 
 
 
+int8_t driver_dir_get_entry(uint32_t dir_cluster, uint32_t entry_index, struct FAT32DirectoryEntry *entry) {
+    if (driver_dir_load_entry_cluster(dir_cluster, entry_index) == FAT32_FAT_END_OF_FILE)
+        return -1;
+    *entry = fat32driver_state.dir_table_buf.table[entry_index % DIRECTORY_TABLE_ENTRY_COUNT];
+    return 0;
+}
+
+int8_t driver_dir_set_entry(uint32_t dir_cluster, uint32_t entry_index, struct FAT32DirectoryEntry entry) {
+    uint32_t entry_cluster = driver_dir_load_entry_cluster(dir_cluster, entry_index);
+    if (entry_cluster == FAT32_FAT_END_OF_FILE)
+        return -1;
+    fat32driver_state.dir_table_buf.table[entry_index % DIRECTORY_TABLE_ENTRY_COUNT] = entry;
+    write_clusters(fat32driver_state.dir_table_buf.table, entry_cluster, 1);
+    return 0;
+}
+
+uint32_t driver_fat_extend_chain(uint32_t last_cluster) {
+    // Prefer physically next cluster to keep chain contiguous
+    uint32_t new_cluster = last_cluster + 1;
+    if (new_cluster >= fat32driver_state.cluster_count || !is_cluster_free(new_cluster))
+        if (!driver_fat_find_contiguous_cluster(1, &new_cluster))
+            return FAT32_FAT_EMPTY_ENTRY;
+
+    driver_fat_set_entry(new_cluster,  FAT32_FAT_END_OF_FILE);
+    driver_fat_set_entry(last_cluster, new_cluster);
+    return new_cluster;
+}
+
+
+
 // -- File system CRUD --
 // Note : Not comprehensive edge case checking, just simple and quick implementation
 int8_t read(struct FAT32DriverRequest request) {
@@ -138,25 +450,32 @@ int8_t read(struct FAT32DriverRequest request) {
     if (!is_loaded_dir_table_valid())
         return -1; // Parent cluster number is not directory
 
-    // Linear scan for entry in dir table
-    int32_t entry_index = driver_dir_table_linear_scan(request.name, request.ext, false);
+    // Search entry in dir table through directory index
+    uint32_t entry_cluster;
+    int32_t  entry_index = driver_dir_table_lookup(request.parent_cluster_number, request.name, request.ext, &entry_cluster);
 
     if (entry_index == -1)
         return 3; // File not found
 
-    struct FAT32DirectoryEntry entry = fat32driver_state.dir_table_buf.table[entry_index];
+    struct FAT32DirectoryEntry entry = fat32driver_state.dir_table_buf.table[entry_index % DIRECTORY_TABLE_ENTRY_COUNT];
     if (entry.attribute & ATTR_SUBDIRECTORY)
         return 1; // Entry is a folder
     else if (entry.filesize > request.buffer_size)
         return 2; // Buffer is too small
 
-    // Read file
+    // Read file, physically contiguous clusters in chain is read with single command
     uint32_t cluster_iterator    = get_cluster_from_entry(entry);
     uint32_t cluster_read_offset = 0;
     do {
-        read_clusters(request.buf + CLUSTER_SIZE*cluster_read_offset, cluster_iterator, 1);
-        cluster_iterator = fat32driver_state.fat_table.cluster_map[cluster_iterator];       // Read next linked list cluster
-        cluster_read_offset++;
+        uint32_t run_length   = 1;
+        uint32_t next_cluster = driver_fat_get_entry(cluster_iterator); // Read next linked list cluster
+        while (next_cluster == cluster_iterator + run_length && run_length < CLUSTER_CONTIGUOUS_MAX) {
+            next_cluster = driver_fat_get_entry(next_cluster);
+            run_length++;
+        }
+        read_clusters(request.buf + CLUSTER_SIZE*cluster_read_offset, cluster_iterator, run_length);
+        cluster_iterator     = next_cluster;
+        cluster_read_offset += run_length;
     } while (cluster_iterator != FAT32_FAT_END_OF_FILE);
 
     return 0;
@@ -169,17 +488,27 @@ int8_t read_directory(struct FAT32DriverRequest request) {
     if (!is_loaded_dir_table_valid())
         return -1; // Parent cluster number is not directory
 
-    int32_t entry_index = driver_dir_table_linear_scan(request.name, "\0\0\0", false);
+    uint32_t entry_cluster;
+    int32_t  entry_index = driver_dir_table_lookup(request.parent_cluster_number, request.name, "\0\0\0", &entry_cluster);
 
     if (entry_index == -1)
         return 2; // Directory not found
 
-    struct FAT32DirectoryEntry entry = fat32driver_state.dir_table_buf.table[entry_index];
+    struct FAT32DirectoryEntry entry = fat32driver_state.dir_table_buf.table[entry_index % DIRECTORY_TABLE_ENTRY_COUNT];
     if ((entry.attribute & ATTR_SUBDIRECTORY) == 0)
         return 1; // Not a directory
 
-    // Read directory
-    read_clusters(request.buf, get_cluster_from_entry(entry), 1);
+    // Read directory chain as long as it fit into buffer, first cluster is always read
+    uint32_t table_capacity   = request.buffer_size / sizeof(struct FAT32DirectoryTable);
+    uint32_t table_count      = 0;
+    uint32_t cluster_iterator = get_cluster_from_entry(entry);
+    struct FAT32DirectoryTable *table = request.buf;
+    do {
+        read_clusters(&table[table_count++], cluster_iterator, 1);
+        cluster_iterator = driver_fat_get_entry(cluster_iterator);
+    } while (cluster_iterator != FAT32_FAT_END_OF_FILE && table_count < table_capacity);
+    if (table_count < table_capacity)
+        memset(&table[table_count], 0, (table_capacity - table_count) * sizeof(struct FAT32DirectoryTable));
 
     return 0;
 }
@@ -191,12 +520,14 @@ int8_t write(struct FAT32DriverRequest request) {
     if (!is_loaded_dir_table_valid())
         return -1; // Parent cluster number is not directory
 
-    int32_t same_name_index   = driver_dir_table_linear_scan(request.name, request.ext, false);
-    int32_t empty_entry_index = driver_dir_table_linear_scan(request.name, request.ext, true);
-
+    uint32_t entry_cluster;
+    int32_t  same_name_index = driver_dir_table_lookup(request.parent_cluster_number, request.name, request.ext, &entry_cluster);
     if (same_name_index != -1)
         return 1; // Entry with same name already exist
-    else if (empty_entry_index == -1)
+
+    // Empty entry search may grow directory chain, dir_table_buf will hold entry_cluster afterward
+    int32_t empty_entry_index = driver_dir_table_find_empty(request.parent_cluster_number, &entry_cluster);
+    if (empty_entry_index == -1)
         return -1; // No empty entry available
     
     // Scan and mark empty cluster
@@ -206,8 +537,12 @@ int8_t write(struct FAT32DriverRequest request) {
         cluster_count_to_reserve = 1;
     int8_t err_code = driver_fat_mark_empty_cluster(empty_clusters, cluster_count_to_reserve);
     
-    if (err_code == -1)
+    if (err_code == -1) {
+        // Marking only list free cluster, growing directory first keep both from picking same cluster.
+        // Directory cluster grown above is released again, free hint past the chain stay valid
+        driver_dir_shrink(request.parent_cluster_number);
         return -1; // Not enough empty cluster in FAT
+    }
 
     // Create new entry
     struct FAT32DirectoryEntry new_entry = {
@@ -217,7 +552,7 @@ int8_t write(struct FAT32DriverRequest request) {
     memcpy(new_entry.name, request.name, 8);
     memcpy(new_entry.ext,  request.ext,  3);
 
-    // Write actual data
+    // Allocate cluster chain
     new_entry.cluster_high = (uint16_t) (empty_clusters[0] >> 16);
     new_entry.cluster_low  = empty_clusters[0] & 0xFFFF;
     if (request.buffer_size == 0) {
@@ -225,23 +560,32 @@ int8_t write(struct FAT32DriverRequest request) {
         init_directory_table(&new_table, request.name, request.parent_cluster_number);
         new_entry.attribute = 0 | ATTR_SUBDIRECTORY;
 
-        fat32driver_state.fat_table.cluster_map[empty_clusters[0]] = FAT32_FAT_END_OF_FILE;
+        driver_fat_set_entry(empty_clusters[0], FAT32_FAT_END_OF_FILE);
         write_clusters(new_table.table, empty_clusters[0], 1);
     } else {
         for (uint32_t i = 0; i < cluster_count_to_reserve; i++) {
             uint32_t cluster_number = empty_clusters[i];
             if (i == cluster_count_to_reserve - 1)
-                fat32driver_state.fat_table.cluster_map[cluster_number] = FAT32_FAT_END_OF_FILE; // EOF
+                driver_fat_set_entry(cluster_number, FAT32_FAT_END_OF_FILE); // EOF
             else
-                fat32driver_state.fat_table.cluster_map[cluster_number] = empty_clusters[i+1];   // Point into next cluster
-            write_clusters(request.buf + CLUSTER_SIZE*i, cluster_number, 1);
+                driver_fat_set_entry(cluster_number, empty_clusters[i+1]);   // Point into next cluster
+        }
+
+        // Write actual data, physically contiguous clusters is written with single command
+        for (uint32_t i = 0; i < cluster_count_to_reserve;) {
+            uint32_t run_length = 1;
+            while (i + run_length < cluster_count_to_reserve && run_length < CLUSTER_CONTIGUOUS_MAX
+                    && empty_clusters[i + run_length] == empty_clusters[i] + run_length)
+                run_length++;
+            write_clusters(request.buf + CLUSTER_SIZE*i, empty_clusters[i], run_length);
+            i += run_length;
         }
     }
 
     // Update file system metadata in storage
-    fat32driver_state.dir_table_buf.table[empty_entry_index] = new_entry;                      // Insert new entry into dirtable
-    write_clusters(fat32driver_state.dir_table_buf.table,   request.parent_cluster_number, 1); // Dirtable
-    write_clusters(fat32driver_state.fat_table.cluster_map, FAT_CLUSTER_NUMBER, 1);            // FAT
+    fat32driver_state.dir_table_buf.table[empty_entry_index % DIRECTORY_TABLE_ENTRY_COUNT] = new_entry; // Insert new entry into dirtable
+    write_clusters(fat32driver_state.dir_table_buf.table, entry_cluster, 1);                            // Dirtable, FAT is updated in place
+    directory_index_insert(request.parent_cluster_number, new_entry.name, new_entry.ext, empty_entry_index);
 
     return 0;
 }
@@ -253,36 +597,150 @@ int8_t delete(struct FAT32DriverRequest request) {
     if (!is_loaded_dir_table_valid())
         return -1; // Parent cluster number is not directory
 
-    // Linear scan for entry in dir table
-    int32_t entry_index = driver_dir_table_linear_scan(request.name, request.ext, false);
+    // Search entry in dir table through directory index
+    uint32_t entry_cluster;
+    int32_t  entry_index = driver_dir_table_lookup(request.parent_cluster_number, request.name, request.ext, &entry_cluster);
 
     if (entry_index == -1)
         return 1; // File not found
 
-    struct FAT32DirectoryEntry entry = fat32driver_state.dir_table_buf.table[entry_index];
+    uint32_t table_index             = entry_index % DIRECTORY_TABLE_ENTRY_COUNT;
+    struct FAT32DirectoryEntry entry = fat32driver_state.dir_table_buf.table[table_index];
     if (entry.attribute & ATTR_SUBDIRECTORY) {
-        struct FAT32DirectoryTable dirtable;
-        read_clusters(&dirtable, get_cluster_from_entry(entry), 1);
-        if (!is_dirtable_empty(&dirtable))
+        if (!driver_dir_is_empty(get_cluster_from_entry(entry)))
             return 2; // Folder is not empty
+        directory_index_invalidate(get_cluster_from_entry(entry));
     }
 
     // Remove entry from parent directory
-    fat32driver_state.dir_table_buf.table[entry_index].user_attribute = 0;
-    memset(fat32driver_state.dir_table_buf.table[entry_index].name, 0, 8);
-    memset(fat32driver_state.dir_table_buf.table[entry_index].ext, 0, 3);
+    directory_index_remove(request.parent_cluster_number, entry.name, entry.ext);
+    fat32driver_state.dir_table_buf.table[table_index].user_attribute = 0;
+    memset(fat32driver_state.dir_table_buf.table[table_index].name, 0, 8);
+    memset(fat32driver_state.dir_table_buf.table[table_index].ext, 0, 3);
 
-    // Remove FAT cluster number
+    // Remove FAT cluster number, resident executable page of released chain is stale
     uint32_t cluster_iterator = get_cluster_from_entry(entry);
+    image_cache_invalidate(cluster_iterator);
     do {
-        uint32_t next_iter = fat32driver_state.fat_table.cluster_map[cluster_iterator]; // Read & save next linked list cluster
-        fat32driver_state.fat_table.cluster_map[cluster_iterator] = FAT32_FAT_EMPTY_ENTRY;
+        uint32_t next_iter = driver_fat_get_entry(cluster_iterator); // Read & save next linked list cluster
+        driver_fat_set_entry(cluster_iterator, FAT32_FAT_EMPTY_ENTRY);
         cluster_iterator   = next_iter;
     } while (cluster_iterator != FAT32_FAT_END_OF_FILE);
 
     // Update file system metadata in storage
-    write_clusters(fat32driver_state.dir_table_buf.table,   request.parent_cluster_number, 1); // Dirtable
-    write_clusters(fat32driver_state.fat_table.cluster_map, FAT_CLUSTER_NUMBER, 1);            // FAT
+    write_clusters(fat32driver_state.dir_table_buf.table, entry_cluster, 1); // Dirtable, FAT is updated in place
+    driver_dir_shrink(request.parent_cluster_number);
+
+    return 0;
+}
+
+
 
+// -- Defragmentation --
+// Relocate cluster chain into single contiguous extent. Error code: 0 success - 2 not enough contiguous space
+static int8_t driver_fat_relocate_chain(uint32_t first_cluster, uint32_t *new_first_cluster) {
+    uint32_t chain_length  = 1;
+    bool     is_contiguous = true;
+    for (uint32_t iter = first_cluster; driver_fat_get_entry(iter) != FAT32_FAT_END_OF_FILE; chain_length++) {
+        uint32_t next = driver_fat_get_entry(iter);
+        is_contiguous = is_contiguous && next == iter + 1;
+        iter          = next;
+    }
+
+    *new_first_cluster = first_cluster;
+    if (is_contiguous)
+        return 0;
+
+    uint32_t start_cluster;
+    if (!driver_fat_find_contiguous_cluster(chain_length, &start_cluster))
+        return 2;
+
+    // Copy data into new extent and link new chain, old chain is untouched until copy finished
+    uint32_t cluster_iterator = first_cluster;
+    for (uint32_t i = 0; i < chain_length; i++) {
+        read_clusters(&fat32driver_state.cluster_buf, cluster_iterator, 1);
+        write_clusters(&fat32driver_state.cluster_buf, start_cluster + i, 1);
+        driver_fat_set_entry(start_cluster + i, i == chain_length - 1 ? FAT32_FAT_END_OF_FILE : start_cluster + i + 1);
+        cluster_iterator = driver_fat_get_entry(cluster_iterator);
+    }
+
+    image_cache_invalidate(first_cluster);
+    cluster_iterator = first_cluster;
+    do {
+        uint32_t next_iter = driver_fat_get_entry(cluster_iterator);
+        driver_fat_set_entry(cluster_iterator, FAT32_FAT_EMPTY_ENTRY);
+        cluster_iterator   = next_iter;
+    } while (cluster_iterator != FAT32_FAT_END_OF_FILE);
+
+    *new_first_cluster = start_cluster;
     return 0;
-}
\ No newline at end of file
+}
+
+static void set_cluster_to_entry(struct FAT32DirectoryEntry *entry, uint32_t cluster_number) {
+    entry->cluster_high = (uint16_t) (cluster_number >> 16);
+    entry->cluster_low  = cluster_number & 0xFFFF;
+}
+
+int8_t defragment(struct FAT32DriverRequest request) {
+    read_clusters(&fat32driver_state.dir_table_buf, request.parent_cluster_number, 1);
+
+    if (!is_loaded_dir_table_valid())
+        return -1; // Parent cluster number is not directory
+
+    uint32_t entry_cluster;
+    int32_t  entry_index = driver_dir_table_lookup(request.parent_cluster_number, request.name, request.ext, &entry_cluster);
+    if (entry_index == -1)
+        return 3; // File not found
+
+    struct FAT32DirectoryEntry *entry = &fat32driver_state.dir_table_buf.table[entry_index % DIRECTORY_TABLE_ENTRY_COUNT];
+    if (entry->attribute & ATTR_SUBDIRECTORY)
+        return 1; // Entry is a folder
+
+    uint32_t new_first_cluster;
+    int8_t   err_code = driver_fat_relocate_chain(get_cluster_from_entry(*entry), &new_first_cluster);
+    if (err_code != 0)
+        return err_code;
+
+    // Relocation may use cluster_buf only, dir_table_buf is still valid
+    set_cluster_to_entry(entry, new_first_cluster);
+    write_clusters(fat32driver_state.dir_table_buf.table, entry_cluster, 1); // Dirtable, FAT is updated in place
+    return 0;
+}
+
+static uint32_t driver_defragment_directory(uint32_t dir_cluster) {
+    struct FAT32DirectoryTable dir_table;
+    uint32_t relocated_count  = 0;
+    uint32_t cluster_iterator = dir_cluster;
+    do {
+        bool is_modified = false;
+        read_clusters(&dir_table, cluster_iterator, 1);
+
+        // Skipping index 0 & 1 of first cluster, self and parent entry
+        for (uint32_t i = cluster_iterator == dir_cluster ? 2 : 0; i < DIRECTORY_TABLE_ENTRY_COUNT; i++) {
+            struct FAT32DirectoryEntry *entry = &dir_table.table[i];
+            if (!(entry->user_attribute & UATTR_NOT_EMPTY))
+                continue;
+
+            uint32_t first_cluster = get_cluster_from_entry(*entry);
+            if (entry->attribute & ATTR_SUBDIRECTORY) {
+                relocated_count += driver_defragment_directory(first_cluster);
+            } else {
+                uint32_t new_first_cluster;
+                if (driver_fat_relocate_chain(first_cluster, &new_first_cluster) == 0 && new_first_cluster != first_cluster) {
+                    set_cluster_to_entry(entry, new_first_cluster);
+                    is_modified = true;
+                    relocated_count++;
+                }
+            }
+        }
+
+        if (is_modified)
+            write_clusters(dir_table.table, cluster_iterator, 1);
+        cluster_iterator = driver_fat_get_entry(cluster_iterator);
+    } while (cluster_iterator != FAT32_FAT_END_OF_FILE);
+    return relocated_count;
+}
+
+uint32_t defragment_all(void) {
+    return driver_defragment_directory(ROOT_CLUSTER_NUMBER);
+}
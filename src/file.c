@@ -0,0 +1,232 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/filesystem/file.h"
+#include "header/filesystem/buffer-cache.h"
+#include "header/filesystem/image-cache.h"
+#include "header/stdlib/string.h"
+
+/**
+ * File handle states
+ *
+ * @param handle      All file handles, file descriptor is index into this array
+ * @param zero_buffer Empty cluster used for creating new file
+ */
+static struct {
+    struct FileHandle    handle[FILE_HANDLE_COUNT_MAX];
+    struct ClusterBuffer zero_buffer;
+} file_state = {0};
+
+
+
+// -- Internal helper --
+static struct FileHandle* file_get_handle(int32_t fd) {
+    if (fd < 0 || fd >= FILE_HANDLE_COUNT_MAX || !file_state.handle[fd].used)
+        return NULL;
+    return &file_state.handle[fd];
+}
+
+/**
+ * Move cursor into cluster_index-th cluster in chain. Walk forward from cached cursor,
+ * only restart from first cluster when moving backward
+ *
+ * @return uint32_t Cluster number, FAT32_FAT_END_OF_FILE if chain is shorter and cannot be extended
+ */
+static uint32_t file_cursor_move(struct FileHandle *handle, uint32_t cluster_index, bool extend) {
+    if (cluster_index < handle->cursor_cluster_index) {
+        handle->cursor_cluster       = handle->first_cluster;
+        handle->cursor_cluster_index = 0;
+    }
+    while (handle->cursor_cluster_index < cluster_index) {
+        uint32_t next_cluster = driver_fat_get_entry(handle->cursor_cluster);
+        if (next_cluster == FAT32_FAT_END_OF_FILE) {
+            if (!extend)
+                return FAT32_FAT_END_OF_FILE;
+            next_cluster = driver_fat_extend_chain(handle->cursor_cluster);
+            if (next_cluster == FAT32_FAT_EMPTY_ENTRY)
+                return FAT32_FAT_END_OF_FILE;
+        }
+        handle->cursor_cluster = next_cluster;
+        handle->cursor_cluster_index++;
+    }
+    return handle->cursor_cluster;
+}
+
+
+
+// -- Public interfaces --
+int32_t file_open(struct FAT32DriverRequest request, uint8_t mode, uint32_t owner) {
+    int32_t fd = -1;
+    for (int32_t i = 0; i < FILE_HANDLE_COUNT_MAX && fd == -1; i++)
+        if (!file_state.handle[i].used)
+            fd = i;
+    if (fd == -1)
+        return FILE_OPEN_FAIL_HANDLE_EXCEEDED;
+
+    // Entry 0 of valid directory is self entry
+    struct FAT32DirectoryEntry entry;
+    if (driver_dir_get_entry(request.parent_cluster_number, 0, &entry) != 0
+            || entry.user_attribute != UATTR_NOT_EMPTY || !(entry.attribute & ATTR_SUBDIRECTORY))
+        return FILE_OPEN_FAIL_INVALID_PARENT;
+
+    uint32_t entry_cluster;
+    int32_t  entry_index = driver_dir_table_lookup(request.parent_cluster_number, request.name, request.ext, &entry_cluster);
+    if (entry_index == -1) {
+        if (!(mode & FILE_MODE_CREATE))
+            return FILE_OPEN_FAIL_NOT_FOUND;
+
+        // write() reserve at least single cluster, filesize is reset afterward
+        request.buf         = &file_state.zero_buffer;
+        request.buffer_size = 1;
+        if (write(request) != 0)
+            return FILE_OPEN_FAIL_CREATE;
+        entry_index = driver_dir_table_lookup(request.parent_cluster_number, request.name, request.ext, &entry_cluster);
+        driver_dir_get_entry(request.parent_cluster_number, entry_index, &entry);
+        entry.filesize = 0;
+        driver_dir_set_entry(request.parent_cluster_number, entry_index, entry);
+    }
+
+    driver_dir_get_entry(request.parent_cluster_number, entry_index, &entry);
+    if (entry.attribute & ATTR_SUBDIRECTORY)
+        return FILE_OPEN_FAIL_IS_DIRECTORY;
+
+    struct FileHandle *handle    = &file_state.handle[fd];
+    handle->used                 = true;
+    handle->owner                = owner;
+    handle->mode                 = mode;
+    handle->parent_cluster       = request.parent_cluster_number;
+    handle->entry_index          = entry_index;
+    handle->first_cluster        = get_cluster_from_entry(entry);
+    handle->filesize             = entry.filesize;
+    handle->offset               = 0;
+    handle->cursor_cluster       = handle->first_cluster;
+    handle->cursor_cluster_index = 0;
+    return fd;
+}
+
+int32_t file_read(int32_t fd, void *buf, uint32_t size) {
+    struct FileHandle *handle = file_get_handle(fd);
+    if (handle == NULL || !(handle->mode & FILE_MODE_READ))
+        return -1;
+    if (handle->offset >= handle->filesize)
+        return 0;
+    if (size > handle->filesize - handle->offset)
+        size = handle->filesize - handle->offset;
+
+    uint32_t read_size = 0;
+    while (read_size < size) {
+        uint32_t cluster_offset = handle->offset % CLUSTER_SIZE;
+        uint32_t cluster_number = file_cursor_move(handle, handle->offset / CLUSTER_SIZE, false);
+        uint32_t chunk_size;
+        if (cluster_number == FAT32_FAT_END_OF_FILE)
+            break;
+
+        if (cluster_offset == 0 && size - read_size >= CLUSTER_SIZE) {
+            // Whole cluster, physically contiguous clusters is read with single command
+            uint32_t run_length = 1;
+            while (run_length < (size - read_size) / CLUSTER_SIZE && run_length < CLUSTER_CONTIGUOUS_MAX
+                    && driver_fat_get_entry(cluster_number + run_length - 1) == cluster_number + run_length)
+                run_length++;
+            read_clusters((uint8_t*) buf + read_size, cluster_number, run_length);
+            handle->cursor_cluster        = cluster_number + run_length - 1;
+            handle->cursor_cluster_index += run_length - 1;
+            chunk_size                    = run_length * CLUSTER_SIZE;
+        } else {
+            // Partial cluster, copy from buffer cache
+            uint8_t *cluster_data = buffer_cache_get(cluster_number);
+            chunk_size            = CLUSTER_SIZE - cluster_offset;
+            if (chunk_size > size - read_size)
+                chunk_size = size - read_size;
+            memcpy((uint8_t*) buf + read_size, cluster_data + cluster_offset, chunk_size);
+        }
+        read_size      += chunk_size;
+        handle->offset += chunk_size;
+    }
+    return read_size;
+}
+
+int32_t file_write(int32_t fd, const void *buf, uint32_t size) {
+    struct FileHandle *handle = file_get_handle(fd);
+    if (handle == NULL || !(handle->mode & FILE_MODE_WRITE))
+        return -1;
+    if (handle->mode & FILE_MODE_APPEND)
+        handle->offset = handle->filesize;
+    image_cache_invalidate(handle->first_cluster);
+
+    uint32_t written_size = 0;
+    while (written_size < size) {
+        uint32_t cluster_offset = handle->offset % CLUSTER_SIZE;
+        uint32_t cluster_number = file_cursor_move(handle, handle->offset / CLUSTER_SIZE, true);
+        if (cluster_number == FAT32_FAT_END_OF_FILE)
+            break; // Storage is full
+
+        uint32_t chunk_size = CLUSTER_SIZE - cluster_offset;
+        if (chunk_size > size - written_size)
+            chunk_size = size - written_size;
+        if (chunk_size == CLUSTER_SIZE) {
+            // Whole cluster overwrite, no need to load old content
+            write_clusters((uint8_t*) buf + written_size, cluster_number, 1);
+        } else {
+            uint8_t *cluster_data = buffer_cache_get(cluster_number);
+            memcpy(cluster_data + cluster_offset, (uint8_t*) buf + written_size, chunk_size);
+            buffer_cache_mark_dirty(cluster_number, cluster_offset, chunk_size);
+        }
+        written_size   += chunk_size;
+        handle->offset += chunk_size;
+    }
+
+    // Grown file, update filesize in parent directory
+    if (handle->offset > handle->filesize) {
+        struct FAT32DirectoryEntry entry;
+        handle->filesize = handle->offset;
+        driver_dir_get_entry(handle->parent_cluster, handle->entry_index, &entry);
+        entry.filesize = handle->filesize;
+        driver_dir_set_entry(handle->parent_cluster, handle->entry_index, entry);
+    }
+    return written_size;
+}
+
+int32_t file_seek(int32_t fd, int32_t offset, uint8_t whence) {
+    struct FileHandle *handle = file_get_handle(fd);
+    if (handle == NULL)
+        return -1;
+
+    int32_t base;
+    switch (whence) {
+        case FILE_SEEK_SET: base = 0;                          break;
+        case FILE_SEEK_CUR: base = (int32_t) handle->offset;   break;
+        case FILE_SEEK_END: base = (int32_t) handle->filesize; break;
+        default:            return -1;
+    }
+    int32_t new_offset = base + offset;
+    if (new_offset < 0 || (uint32_t) new_offset > handle->filesize)
+        return -1;
+
+    // Cursor cluster is moved lazily on next read / write
+    handle->offset = new_offset;
+    return new_offset;
+}
+
+int8_t file_close(int32_t fd) {
+    struct FileHandle *handle = file_get_handle(fd);
+    if (handle == NULL)
+        return -1;
+    handle->used = false;
+    return 0;
+}
+
+uint32_t file_get_first_cluster(int32_t fd) {
+    struct FileHandle *handle = file_get_handle(fd);
+    return handle != NULL ? handle->first_cluster : 0;
+}
+
+bool file_is_owned(int32_t fd, uint32_t owner) {
+    struct FileHandle *handle = file_get_handle(fd);
+    return handle != NULL && handle->owner == owner;
+}
+
+void file_close_all(uint32_t owner) {
+    for (uint32_t i = 0; i < FILE_HANDLE_COUNT_MAX; i++)
+        if (file_state.handle[i].used && file_state.handle[i].owner == owner)
+            file_state.handle[i].used = false;
+}
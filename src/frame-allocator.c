@@ -0,0 +1,225 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/memory/frame-allocator.h"
+#include "header/stdlib/string.h"
+
+/**
+ * Buddy allocator states. Free block of order k is 2^k page frame aligned to its size,
+ * every order have doubly linked free list threaded through the free blocks
+ *
+ * @param free_head      First free block frame index for every order
+ * @param free_bitmap    Bit set if block is head of free block with that order, order k start at bitmap_offset(k)
+ * @param nonempty_order Bit k set if free_head[k] is not empty, lowest usable order is found with bsf
+ * @param reference      Reference count of every allocated block, indexed by its first frame index.
+ *                       Allocated from allocator itself after memory detection
+ * @param statistic      Allocator counters
+ */
+static struct {
+    uint32_t                       free_head[FRAME_ORDER_COUNT];
+    uint32_t                       free_bitmap[FRAME_BITMAP_WORD_COUNT];
+    uint32_t                       nonempty_order;
+    uint16_t                       *reference;
+    struct FrameAllocatorStatistic statistic;
+} frame_allocator_state = {
+    .free_head      = {[0 ... FRAME_ORDER_MAX] = FRAME_INVALID_INDEX},
+    .nonempty_order = 0,
+    .reference      = NULL,
+};
+
+
+
+// -- Internal helper --
+// Bit offset of first block of order in free_bitmap
+static uint32_t bitmap_offset(uint8_t order) {
+    return 2*FRAME_MAX_COUNT - (2*FRAME_MAX_COUNT >> order);
+}
+
+static bool bitmap_test(uint32_t frame_index, uint8_t order) {
+    uint32_t bit = bitmap_offset(order) + (frame_index >> order);
+    return frame_allocator_state.free_bitmap[bit / 32] & (1u << (bit % 32));
+}
+
+static void bitmap_set(uint32_t frame_index, uint8_t order, bool value) {
+    uint32_t bit = bitmap_offset(order) + (frame_index >> order);
+    if (value)
+        frame_allocator_state.free_bitmap[bit / 32] |= 1u << (bit % 32);
+    else
+        frame_allocator_state.free_bitmap[bit / 32] &= ~(1u << (bit % 32));
+}
+
+static struct FrameFreeBlock* free_block(uint32_t frame_index) {
+    return PAGING_DIRECT_MAP(frame_index * PAGE_FRAME_SIZE);
+}
+
+static void free_list_push(uint32_t frame_index, uint8_t order) {
+    struct FrameFreeBlock *block = free_block(frame_index);
+    block->prev = FRAME_INVALID_INDEX;
+    block->next = frame_allocator_state.free_head[order];
+    if (block->next != FRAME_INVALID_INDEX)
+        free_block(block->next)->prev = frame_index;
+    frame_allocator_state.free_head[order] = frame_index;
+    frame_allocator_state.nonempty_order  |= 1u << order;
+    frame_allocator_state.statistic.free_block_count[order]++;
+    bitmap_set(frame_index, order, true);
+}
+
+static void free_list_remove(uint32_t frame_index, uint8_t order) {
+    struct FrameFreeBlock *block = free_block(frame_index);
+    if (block->prev != FRAME_INVALID_INDEX)
+        free_block(block->prev)->next = block->next;
+    else
+        frame_allocator_state.free_head[order] = block->next;
+    if (block->next != FRAME_INVALID_INDEX)
+        free_block(block->next)->prev = block->prev;
+    if (frame_allocator_state.free_head[order] == FRAME_INVALID_INDEX)
+        frame_allocator_state.nonempty_order &= ~(1u << order);
+    frame_allocator_state.statistic.free_block_count[order]--;
+    bitmap_set(frame_index, order, false);
+}
+
+// Insert free block and merge with its buddy as long as buddy is also free
+static void free_block_insert(uint32_t frame_index, uint8_t order) {
+    while (order < FRAME_ORDER_MAX) {
+        uint32_t buddy_index = frame_index ^ (1u << order);
+        if (!bitmap_test(buddy_index, order))
+            break;
+        free_list_remove(buddy_index, order);
+        frame_index &= ~(1u << order);
+        order++;
+    }
+    free_list_push(frame_index, order);
+}
+
+// Release [start, end) frame range as largest aligned blocks
+static void free_range_insert(uint32_t start, uint32_t end) {
+    while (start < end) {
+        uint8_t order = 0;
+        while (order < FRAME_ORDER_MAX && !(start & (1u << order)) && start + (2u << order) <= end)
+            order++;
+        free_block_insert(start, order);
+        frame_allocator_state.statistic.total_frame += 1u << order;
+        frame_allocator_state.statistic.free_frame  += 1u << order;
+        start += 1u << order;
+    }
+}
+
+// Clamp physical range into managed frame index range, then release it
+static void free_physical_range_insert(uint64_t base, uint64_t length) {
+    uint64_t memory_end = (uint64_t) FRAME_MAX_COUNT * PAGE_FRAME_SIZE;
+    uint64_t end        = base + length;
+    if (end > memory_end)
+        end = memory_end;
+    // Partial frame at both side is unusable
+    uint64_t start = (base + PAGE_FRAME_SIZE - 1) & ~((uint64_t) PAGE_FRAME_SIZE - 1);
+    end           &= ~((uint64_t) PAGE_FRAME_SIZE - 1);
+    if (start < (uint64_t) PAGE_FRAME_KERNEL_RESERVED_COUNT * PAGE_FRAME_SIZE)
+        start = (uint64_t) PAGE_FRAME_KERNEL_RESERVED_COUNT * PAGE_FRAME_SIZE;
+    if (start < end)
+        free_range_insert((uint32_t) start / PAGE_FRAME_SIZE, (uint32_t) end / PAGE_FRAME_SIZE);
+}
+
+
+
+// -- Public interfaces --
+void frame_allocator_initialize(uint32_t multiboot_magic, uint32_t multiboot_info_phys_addr) {
+    struct MultibootInfo *info        = PAGING_DIRECT_MAP(multiboot_info_phys_addr);
+    bool                 is_multiboot = multiboot_magic == MULTIBOOT_BOOTLOADER_MAGIC;
+
+    // Copy available region first, releasing frame write free block header that may overwrite memory map
+    uint64_t region_base[FRAME_MEMORY_REGION_MAX];
+    uint64_t region_length[FRAME_MEMORY_REGION_MAX];
+    uint32_t region_count = 0;
+    if (is_multiboot && (info->flags & MULTIBOOT_INFO_MEMORY_MAP)) {
+        uint32_t mmap_offset = 0;
+        while (mmap_offset < info->mmap_length && region_count < FRAME_MEMORY_REGION_MAX) {
+            struct MultibootMemoryMap *entry = PAGING_DIRECT_MAP(info->mmap_addr + mmap_offset);
+            if (entry->type == MULTIBOOT_MEMORY_AVAILABLE) {
+                region_base[region_count]   = entry->base_addr;
+                region_length[region_count] = entry->length;
+                region_count++;
+            }
+            mmap_offset += entry->size + sizeof(entry->size);
+        }
+    } else if (is_multiboot && (info->flags & MULTIBOOT_INFO_MEMORY)) {
+        // Upper memory is contiguous from 1 MiB
+        region_base[0]   = 1 << 20;
+        region_length[0] = (uint64_t) info->mem_upper << 10;
+        region_count     = 1;
+    } else {
+        region_base[0]   = 0;
+        region_length[0] = (uint64_t) SYSTEM_MEMORY_MB << 20;
+        region_count     = 1;
+    }
+
+    uint64_t memory_end = 0;
+    for (uint32_t i = 0; i < region_count; i++) {
+        free_physical_range_insert(region_base[i], region_length[i]);
+        if (region_base[i] + region_length[i] > memory_end)
+            memory_end = region_base[i] + region_length[i];
+    }
+    if (memory_end > (uint64_t) FRAME_MEMORY_MAX_MB << 20)
+        memory_end = (uint64_t) FRAME_MEMORY_MAX_MB << 20;
+    frame_allocator_state.statistic.memory_size_kb = (uint32_t) memory_end >> 10;
+
+    // Reference count table, one entry for every frame up to memory_end
+    uint32_t reference_size  = (uint32_t) memory_end / PAGE_FRAME_SIZE * sizeof(uint16_t);
+    uint8_t  reference_order = 0;
+    while (reference_order < FRAME_ORDER_MAX && ((uint32_t) PAGE_FRAME_SIZE << reference_order) < reference_size)
+        reference_order++;
+    uint32_t reference_addr = frame_allocate(reference_order);
+    if (reference_addr != FRAME_ALLOCATE_FAIL) {
+        frame_allocator_state.reference = PAGING_DIRECT_MAP(reference_addr);
+        memset(frame_allocator_state.reference, 0, reference_size);
+        frame_allocator_state.reference[reference_addr / PAGE_FRAME_SIZE] = 1;
+    }
+}
+
+uint32_t frame_allocate(uint8_t order) {
+    // Lowest non-empty order at least requested order
+    uint32_t usable_order = frame_allocator_state.nonempty_order & ~((1u << order) - 1);
+    if (order > FRAME_ORDER_MAX || usable_order == 0)
+        return FRAME_ALLOCATE_FAIL;
+    uint32_t block_order;
+    __asm__("bsf %1, %0" : "=r"(block_order) : "rm"(usable_order));
+
+    uint32_t frame_index = frame_allocator_state.free_head[block_order];
+    free_list_remove(frame_index, block_order);
+
+    // Split down, upper half of every split is returned into free list
+    while (block_order > order) {
+        block_order--;
+        free_list_push(frame_index + (1u << block_order), block_order);
+    }
+    frame_allocator_state.statistic.free_frame -= 1u << order;
+    if (frame_allocator_state.reference != NULL)
+        frame_allocator_state.reference[frame_index] = 1;
+    return frame_index * PAGE_FRAME_SIZE;
+}
+
+void frame_free(uint32_t physical_addr, uint8_t order) {
+    uint32_t frame_index = physical_addr / PAGE_FRAME_SIZE;
+    if (frame_allocator_state.reference != NULL && --frame_allocator_state.reference[frame_index] > 0)
+        return;
+    free_block_insert(frame_index, order);
+    frame_allocator_state.statistic.free_frame += 1u << order;
+}
+
+void frame_reference_add(uint32_t physical_addr) {
+    if (frame_allocator_state.reference != NULL)
+        frame_allocator_state.reference[physical_addr / PAGE_FRAME_SIZE]++;
+}
+
+uint32_t frame_reference_count(uint32_t physical_addr) {
+    if (frame_allocator_state.reference == NULL)
+        return 1;
+    return frame_allocator_state.reference[physical_addr / PAGE_FRAME_SIZE];
+}
+
+bool frame_allocate_check(uint32_t amount) {
+    return frame_allocator_state.statistic.free_frame >= amount;
+}
+
+struct FrameAllocatorStatistic frame_allocator_get_statistic(void) {
+    return frame_allocator_state.statistic;
+}
@@ -0,0 +1,95 @@
+#ifndef _APIC_H
+#define _APIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* -- Local APIC constants -- */
+// Register offset, refer to Intel x86 Vol 3a: 11.4.1 The Local APIC Block Diagram
+#define APIC_REGISTER_TASK_PRIORITY   0x080
+#define APIC_REGISTER_EOI             0x0B0
+#define APIC_REGISTER_SPURIOUS        0x0F0
+#define APIC_REGISTER_LVT_TIMER       0x320
+#define APIC_REGISTER_LVT_LINT0       0x350
+#define APIC_REGISTER_LVT_LINT1       0x360
+#define APIC_REGISTER_TIMER_INITIAL   0x380
+#define APIC_REGISTER_TIMER_CURRENT   0x390
+#define APIC_REGISTER_TIMER_DIVIDE    0x3E0
+
+#define MSR_APIC_BASE                 0x1B
+#define MSR_APIC_BASE_ENABLE          (1 << 11)
+#define MSR_APIC_BASE_ADDRESS_MASK    0xFFFFF000
+#define CPUID_FEATURE_EDX_APIC        (1 << 9)
+
+#define APIC_SPURIOUS_ENABLE          (1 << 8)
+#define APIC_LVT_MASKED               (1 << 16)
+#define APIC_LVT_DELIVERY_NMI         (0b100 << 8)
+#define APIC_LVT_DELIVERY_EXTINT      (0b111 << 8)
+// Timer count every 16 bus clock, one-shot mode is LVT timer mode 0
+#define APIC_TIMER_DIVIDE_16          0x3
+
+// Vector above PIC & syscall, spurious vector low 4 bit must be set on older local APIC
+#define APIC_TIMER_VECTOR             0x3E
+#define APIC_SPURIOUS_VECTOR          0x3F
+
+// Calibration window against PIT channel 2, in timer tick (1 ms)
+#define APIC_CALIBRATION_TICK         10
+// Longest one-shot, idle CPU with nothing pending still wake this often to keep elapsed time measurable
+#define APIC_TIMER_MAX_COUNT          0x7FFFFFFF
+
+
+
+/**
+ * Timer counters
+ *
+ * @param tickless        Local APIC one-shot timer is used instead of periodic PIT
+ * @param interrupt_count Timer interrupt received since boot
+ * @param clock_tick      Scheduler clock, timer tick since boot
+ */
+struct TimerStatistic {
+    bool     tickless;
+    uint32_t interrupt_count;
+    uint32_t clock_tick;
+};
+
+
+
+/* -- Local APIC interfaces -- */
+/**
+ * Enable local APIC, keep PIC delivered through LINT0 and calibrate timer against PIT.
+ * Must be called before first process page directory is created, register page is mapped in kernel half
+ *
+ * @return False if CPU has no local APIC or calibration failed, periodic PIT timer should be used instead
+ */
+bool apic_initialize(void);
+
+// Whether local APIC timer is calibrated and usable
+bool apic_timer_available(void);
+
+/**
+ * Arm one-shot timer interrupt on APIC_TIMER_VECTOR, deadline is relative to last tick returned by apic_timer_elapsed_tick().
+ * Timer that is already due fire immediately
+ *
+ * @param tick Timer tick until interrupt, capped by APIC_TIMER_MAX_COUNT
+ */
+void apic_timer_arm(uint32_t tick);
+
+/**
+ * Consume timer tick elapsed since previous call, partial tick is carried into next call
+ *
+ * @return Whole timer tick elapsed
+ */
+uint32_t apic_timer_elapsed_tick(void);
+
+/**
+ * Whole timer tick elapsed but not yet consumed by apic_timer_elapsed_tick()
+ *
+ * @return Pending timer tick
+ */
+uint32_t apic_timer_pending_tick(void);
+
+// Signal end of local APIC interrupt, ignored if no interrupt is in service
+void apic_eoi(void);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef _CLOCKSOURCE_H
+#define _CLOCKSOURCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* -- Clocksource constants -- */
+// Clock ID for clock_gettime() syscall, same numbering as POSIX
+#define CLOCK_REALTIME                 0
+#define CLOCK_MONOTONIC                1
+
+// Return code constant for clocksource_get_time()
+#define CLOCKSOURCE_GET_TIME_SUCCESS   0
+#define CLOCKSOURCE_GET_TIME_FAIL_ID   1
+
+// Calibration window against PIT channel 2 in millisecond, PIT one-shot is limited to 54 ms
+#define CLOCKSOURCE_CALIBRATION_MS     50
+// Cycle to nanosecond is (cycle * mult) >> CLOCKSOURCE_SHIFT, mult fit 32 bit for TSC above 4 MHz
+#define CLOCKSOURCE_SHIFT              24
+#define CLOCKSOURCE_NANOSECOND_PER_SEC 1000000000u
+#define CPUID_FEATURE_EDX_TSC          (1 << 4)
+
+
+
+/**
+ * Time split into second & nanosecond, same layout as POSIX struct timespec with 32-bit field
+ *
+ * @param second     Whole second
+ * @param nanosecond [0, 999999999]
+ */
+struct ClockTimespec {
+    uint32_t second;
+    uint32_t nanosecond;
+};
+
+
+
+/* -- Clocksource interfaces -- */
+/**
+ * Calibrate TSC against PIT and take initial wall-clock time from cached CMOS data.
+ * Timer tick is used as millisecond clocksource if CPU has no TSC
+ */
+void clocksource_initialize(void);
+
+/**
+ * Monotonic nanosecond since clocksource_initialize()
+ *
+ * @return Nanosecond, TSC resolution or millisecond if TSC is unavailable
+ */
+uint64_t clocksource_get_monotonic_ns(void);
+
+/**
+ * Re-anchor wall clock at RTC second edge, called from every RTC update-ended interrupt.
+ * Wall clock ahead of RTC stand still until RTC catch up, so TSC calibration error never accumulate
+ * and wall-clock time never step backward within a second
+ *
+ * @param epoch_second UTC second since 1970-01-01 of the new RTC second
+ */
+void clocksource_sync_wall_clock(uint32_t epoch_second);
+
+/**
+ * Read clock as POSIX clock_gettime()
+ *
+ * @param clock_id CLOCK_REALTIME or CLOCK_MONOTONIC
+ * @param time     Resulting time
+ * @return         CLOCKSOURCE_GET_TIME_* return code
+ */
+int8_t clocksource_get_time(uint32_t clock_id, struct ClockTimespec *time);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef _FPU_H
+#define _FPU_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* -- FPU constants -- */
+// FXSAVE area size & alignment, refer to Intel x86 Vol 1: 10.5.1 FXSAVE Area
+#define FPU_STATE_SIZE           512
+#define FPU_STATE_ALIGN          16
+// MXCSR power-on value, every SIMD exception masked
+#define FPU_MXCSR_DEFAULT        0x1F80
+
+#define CPU_CR0_MONITOR_COPROCESSOR (1 << 1)
+#define CPU_CR0_EMULATION           (1 << 2)
+#define CPU_CR0_TASK_SWITCHED       (1 << 3)
+#define CPU_CR0_NUMERIC_ERROR       (1 << 5)
+#define CPU_CR4_OSFXSR              (1 << 9)
+#define CPU_CR4_OSXMMEXCPT          (1 << 10)
+#define CPUID_FEATURE_EDX_FXSR      (1 << 24)
+#define CPUID_FEATURE_EDX_SSE2      (1 << 26)
+
+struct ProcessControlBlock;
+
+
+
+/**
+ * x87, MMX & SSE register state in FXSAVE format
+ *
+ * @param area FXSAVE / FXRSTOR memory image
+ */
+struct FPUState {
+    uint8_t area[FPU_STATE_SIZE];
+} __attribute__((aligned(FPU_STATE_ALIGN)));
+
+
+
+/* -- Lazy FPU interfaces -- */
+/**
+ * Enable x87 & SSE for user mode if CPU support FXSAVE, leave FPU disabled otherwise.
+ * FPU register is saved only when other process use it, first use of every quantum raise device-not-available.
+ * Kernel SSE2 memcpy() is enabled if CPU support SSE2
+ */
+void fpu_initialize(void);
+
+/**
+ * Make FPU register usable by kernel, live state of owner is saved and restored lazily on its next use.
+ * Must not be nested, every fpu_kernel_begin() is followed by fpu_kernel_end()
+ */
+void fpu_kernel_begin(void);
+
+// Give FPU register back after kernel use, next user FPU access trap
+void fpu_kernel_end(void);
+
+/**
+ * Called before switching into process, FPU access trap unless process already own FPU register
+ *
+ * @param pcb Process that will run
+ */
+void fpu_switch_process(struct ProcessControlBlock *pcb);
+
+/**
+ * Device-not-available (#NM) handler. Save FPU register of previous owner,
+ * then restore running process state or give it fresh state on first use
+ *
+ * @return False if FPU is unsupported, no process is running or state cannot be allocated
+ */
+bool fpu_handle_device_not_available(void);
+
+/**
+ * Copy FPU state of parent into forked child, child without FPU state start fresh on first use
+ *
+ * @param parent Running process
+ * @param child  New process
+ * @return       False if state cannot be allocated
+ */
+bool fpu_fork(struct ProcessControlBlock *parent, struct ProcessControlBlock *child);
+
+/**
+ * Release FPU state of destroyed process, FPU register is no longer owned by it
+ *
+ * @param pcb Destroyed process
+ */
+void fpu_release(struct ProcessControlBlock *pcb);
+
+#endif
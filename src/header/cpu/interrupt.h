@@ -59,6 +59,10 @@
 #define IRQ_PRIMARY_ATA  14
 #define IRQ_SECOND_ATA   15
 
+/* -- Syscall constants -- */
+// Syscall number is eax, valid number is below this
+#define SYSCALL_COUNT    30
+
 extern struct TSSEntry _interrupt_tss_entry;
 
 /**
@@ -142,9 +146,53 @@ struct InterruptFrame {
 // Activate PIC mask for keyboard only
 void activate_keyboard_interrupt(void);
 
-// Activate PIC mask for timer only
+/**
+ * Start scheduler timer. Tickless one-shot local APIC timer is used if apic_initialize() succeeded,
+ * otherwise periodic PIT IRQ is unmasked
+ */
 void activate_timer_interrupt(void);
 
+/**
+ * Start PIT channel 2 one-shot count without interrupt, used to calibrate other clock at boot
+ *
+ * @param ms Duration in millisecond, at most 54
+ */
+void pit_oneshot_start(uint32_t ms);
+
+// Whether PIT channel 2 one-shot started by pit_oneshot_start() has finished
+bool pit_oneshot_done(void);
+
+// Acknowledge timer interrupt in service, either PIC IRQ or local APIC timer. No-op if already acknowledged or none is in service
+void timer_ack(void);
+
+/**
+ * Tickless timer only, account time elapsed since last timer interrupt into scheduler clock & write-back interval.
+ * Periodic timer deliver every tick as interrupt and need no catching up
+ */
+void timer_catch_up(void);
+
+/**
+ * Tickless timer only, arm local APIC timer for next scheduler or write-back event.
+ * Idle CPU with nothing pending is not woken
+ */
+void timer_arm_next_event(void);
+
+/**
+ * Get current timer tick without consuming it, including tickless time not yet accounted into scheduler clock
+ *
+ * @return Timer tick since boot, wrap around
+ */
+uint32_t timer_get_clock_tick(void);
+
+// Activate PIC mask for primary ATA hard disk, including cascade line in master PIC
+void activate_primary_ata_interrupt(void);
+
+// Activate PIC mask for CMOS real-time clock, including cascade line in master PIC
+void activate_cmos_interrupt(void);
+
+// Set SYSENTER MSR for fast syscall entry if CPU support it, must be called after TSS esp0 is set
+void activate_sysenter_syscall(void);
+
 // I/O port wait, around 1-4 microsecond, for I/O synchronization purpose
 void io_wait(void);
 
@@ -173,10 +221,18 @@ void main_interrupt_handler(struct InterruptFrame frame);
 void set_tss_kernel_current_stack(void);
 
 /**
- * Kernel syscall for user mode. This reference guide will use INT $0x30 as syscall
+ * Kernel syscall for user mode, dispatched through syscall table by eax.
+ * Entered from either INT $0x30 or SYSENTER, both build same InterruptFrame
  *
- * @param frame Information about interrupt
+ * @param frame Information about interrupt, resumed context is built from it
+ */
+void syscall(struct InterruptFrame *frame);
+
+/**
+ * SYSENTER entry point, implemented in intsetup.s. DO NOT CALL THIS FUNCTION.
+ * User set eax, ebx, ecx, edx same as INT $0x30, esi with return address and edi with user esp.
+ * ecx & edx is clobbered on return
  */
-void syscall(struct InterruptFrame frame);
+extern void sysenter_handler(void);
 
 #endif
\ No newline at end of file
@@ -37,4 +37,42 @@ void out16(uint16_t port, uint16_t data);
  */
 uint16_t in16(uint16_t port);
 
+/** 
+ *  out32:
+ *  @param port The I/O port to send the data to
+ *  @param data The data to send to the I/O port
+ */
+void out32(uint16_t port, uint32_t data);
+
+/** 
+ *  in32:
+ *  @param port The I/O port to request the data
+ *  @return Recieved data from the corresponding I/O port
+ */
+uint32_t in32(uint16_t port);
+
+/** 
+ *  read_msr:
+ *  @param msr Model specific register address
+ *  @return Value of the model specific register
+ */
+uint64_t read_msr(uint32_t msr);
+
+/** 
+ *  write_msr:
+ *  @param msr   Model specific register address
+ *  @param value Value to write into the model specific register
+ */
+void write_msr(uint32_t msr, uint64_t value);
+
+/** 
+ *  cpuid:
+ *  @param leaf CPUID leaf in eax
+ *  @param eax  Resulting eax
+ *  @param ebx  Resulting ebx
+ *  @param ecx  Resulting ecx
+ *  @param edx  Resulting edx
+ */
+void cpuid(uint32_t leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx);
+
 #endif
\ No newline at end of file
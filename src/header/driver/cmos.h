@@ -13,30 +13,38 @@
 /**
  * CMOS Time information
  * 
- * @param second  [0,59]
- * @param minute  [0,59]
- * @param hour    [0,23] for 24-hour. [1,12] for 12-hour, highest bit is PM marker
- * @param weekday [1,7] with Sunday = 1, Monday = 2, etc
- * @param day     [1,31] day of month
- * @param month   [1,12]
- * @param year    [0,99]
- * @param century [19-20], Note: Untested
+ * @param second      [0,59]
+ * @param minute      [0,59]
+ * @param hour        [0,23] for 24-hour. [1,12] for 12-hour, highest bit is PM marker
+ * @param weekday     [1,7] with Sunday = 1, Monday = 2, etc
+ * @param day         [1,31] day of month
+ * @param month       [1,12]
+ * @param year        [0,99]
+ * @param century     [19-20], Note: Untested
+ * @param millisecond [0,999] interpolated from timer tick since last RTC update
  */
 struct CMOSTimeRTC {
-    uint8_t second;
-    uint8_t minute;
-    uint8_t hour;
-    uint8_t weekday;
-    uint8_t day;
-    uint8_t month;
-    uint8_t year;
-    uint8_t century;
+    uint8_t  second;
+    uint8_t  minute;
+    uint8_t  hour;
+    uint8_t  weekday;
+    uint8_t  day;
+    uint8_t  month;
+    uint8_t  year;
+    uint8_t  century;
+    uint16_t millisecond;
 };
 
 
 
 /* --- CMOS Update & Getter --- */
 
+/**
+ * Enable RTC update-ended interrupt (IRQ 8, once per second) in 24-hour binary mode and read initial time
+ */
+void cmos_initialize();
+
+
 /**
  * Update CMOS driver with latest CMOS data
  * 
@@ -44,12 +52,31 @@ struct CMOSTimeRTC {
  */
 void cmos_fetch_update();
 
+// Update-ended IRQ 8 handler, refresh cached CMOS data without port polling
+void cmos_isr(void);
+
 /**
- * Get current CMOS driver data. 
- * As the name implies, it's not guaranteed to be the latest data
+ * Get current CMOS driver data, refreshed every second by IRQ 8.
+ * Sub-second is interpolated from timer tick, without any CMOS port access
  * 
  * @return Latest driver CMOS data
  */
 struct CMOSTimeRTC cmos_get_current_driver_data();
 
+/**
+ * Monotonic millisecond since cmos_initialize(), whole second counted by RTC update and sub-second interpolated from timer tick.
+ * Never go backward when timer drift against RTC, wrap around after 49 days
+ * 
+ * @return Monotonic millisecond
+ */
+uint32_t cmos_get_monotonic_ms(void);
+
+/**
+ * Convert CMOS time into UTC second since 1970-01-01, sub-second is ignored
+ * 
+ * @param time CMOS time with hour in CMOS_TIMEZONE and date in UTC, as cached by driver
+ * @return     Unix epoch second
+ */
+uint32_t cmos_get_epoch_second(struct CMOSTimeRTC time);
+
 #endif
@@ -12,6 +12,35 @@
 #define ATA_STATUS_DF    0x20
 #define ATA_STATUS_ERR   0x01
 
+#define ATA_DEVICE_CONTROL_PIO  0x3F6
+#define ATA_DEVICE_CONTROL_NIEN 0x02
+
+/* -- ATA commands -- */
+#define ATA_COMMAND_READ_PIO  0x20
+#define ATA_COMMAND_WRITE_PIO 0x30
+#define ATA_COMMAND_READ_DMA  0xC8
+#define ATA_COMMAND_WRITE_DMA 0xCA
+#define ATA_COMMAND_IDENTIFY  0xEC
+
+// IDENTIFY DEVICE word index of 28-bit LBA addressable block count
+#define ATA_IDENTIFY_LBA28_BLOCK_COUNT 60
+
+/* -- Bus Master IDE register offset & flags -- */
+#define ATA_BMI_COMMAND          0x0
+#define ATA_BMI_STATUS           0x2
+#define ATA_BMI_PRDT_ADDRESS     0x4
+
+#define ATA_BMI_COMMAND_START    0x01
+#define ATA_BMI_COMMAND_READ     0x08
+#define ATA_BMI_STATUS_ACTIVE    0x01
+#define ATA_BMI_STATUS_ERROR     0x02
+#define ATA_BMI_STATUS_IRQ       0x04
+
+// 255 blocks spread over 4 KiB pages need up to 33 region
+#define ATA_PRD_MAX_COUNT         64
+#define ATA_PRD_REGION_SIZE_MAX   0x10000
+#define ATA_PRD_FLAG_END_OF_TABLE 0x8000
+
 #define BLOCK_SIZE      512
 #define HALF_BLOCK_SIZE (BLOCK_SIZE/2)
 
@@ -22,11 +51,105 @@ struct BlockBuffer {
     uint8_t buf[BLOCK_SIZE];
 } __attribute__((packed));
 
+/**
+ * Physical Region Descriptor, single entry of PRD table used by bus master DMA.
+ * Region must not cross 64 KiB physical boundary
+ * 
+ * @param physical_addr Physical address of memory region, must be even
+ * @param byte_count    Region size in bytes, 0 means 64 KiB
+ * @param flag          ATA_PRD_FLAG_END_OF_TABLE for last entry in table
+ */
+struct ATAPhysicalRegionDescriptor {
+    uint32_t physical_addr;
+    uint16_t byte_count;
+    uint16_t flag;
+} __attribute__((packed));
+
+
+/**
+ * Block request status, request is owned by driver while PENDING or IN_FLIGHT
+ */
+typedef enum BLOCK_REQUEST_STATUS {
+    BLOCK_REQUEST_PENDING   = 0,
+    BLOCK_REQUEST_IN_FLIGHT = 1,
+    BLOCK_REQUEST_DONE      = 2,
+    BLOCK_REQUEST_ERROR     = 3,
+} BLOCK_REQUEST_STATUS;
+
+/**
+ * Asynchronous block I/O request. Memory is owned by submitter and must stay valid until completion.
+ * 
+ * @param buf                   Pointer to data buffer, at least block_count * BLOCK_SIZE bytes
+ * @param logical_block_address Starting block address, use LBA addressing
+ * @param block_count           How many block to transfer
+ * @param is_write              Transfer direction, true for writing buf into disk
+ * @param callback              Optional, called from IRQ14 context when request is completed
+ * @param callback_data         Optional, free to use by submitter
+ * 
+ * Driver-managed
+ * @param status                Current request status
+ * @param page_dir              Address space buf belong to, captured during submit
+ * @param use_dma               Whether this request is serviced with bus master DMA
+ * @param block_done            Transferred block count, used by PIO
+ * @param next                  Next request in queue
+ */
+struct BlockRequest {
+    void                 *buf;
+    uint32_t             logical_block_address;
+    uint8_t              block_count;
+    bool                 is_write;
+    void                 (*callback)(struct BlockRequest *request);
+    void                 *callback_data;
+
+    volatile BLOCK_REQUEST_STATUS status;
+    struct PageDirectory *page_dir;
+    bool                 use_dma;
+    uint8_t              block_done;
+    struct BlockRequest  *next;
+};
+
+
+
+/**
+ * Activate IRQ14, probe PCI bus for IDE bus master controller and enable DMA transfer if found.
+ * Driver will use ATA PIO as fallback if no bus master controller detected.
+ * Must be called before any read_blocks() / write_blocks()
+ */
+void disk_initialize(void);
+
+// Addressable block count reported by IDENTIFY DEVICE during disk_initialize(), 0 if unknown
+uint32_t disk_get_block_count(void);
+
+// Check whether bus master DMA detected during disk_initialize()
+bool disk_is_dma_available(void);
 
+// Toggle DMA usage, useful for comparing with PIO - @param enable Ignored if DMA is not available
+void disk_set_dma_enable(bool enable);
+
+/**
+ * Queue block request, disk will be started immediately if idle.
+ * Completion is signaled with IRQ14, check request status or use callback
+ * 
+ * @param request Request to submit, all non driver-managed attribute should be set
+ */
+void disk_submit_request(struct BlockRequest *request);
+
+/**
+ * Sleep with hlt until request is completed. Other interrupts still serviced while waiting
+ * 
+ * @param request Already submitted request
+ */
+void disk_wait_request(struct BlockRequest *request);
+
+/**
+ * Primary ATA interrupt service routine, complete current request and start next queued request.
+ * Note: Called from main_interrupt_handler()
+ */
+void disk_isr(void);
 
 /**
- * ATA PIO logical block address read blocks. Will blocking until read is completed.
- * Note: ATA PIO will use 2-bytes per read/write operation.
+ * ATA logical block address read blocks. Submit request and sleep until read is completed.
+ * Note: Use bus master DMA if available, otherwise ATA PIO will use 2-bytes per read/write operation.
  * Recommended to use struct BlockBuffer
  * 
  * @param ptr                   Pointer for storing reading data, this pointer should point to already allocated memory location.
@@ -37,8 +160,8 @@ struct BlockBuffer {
 void read_blocks(void *ptr, uint32_t logical_block_address, uint8_t block_count);
 
 /**
- * ATA PIO logical block address write blocks. Will blocking until write is completed.
- * Note: ATA PIO will use 2-bytes per read/write operation.
+ * ATA logical block address write blocks. Submit request and sleep until write is completed.
+ * Note: Use bus master DMA if available, otherwise ATA PIO will use 2-bytes per read/write operation.
  * Recommended to use struct BlockBuffer
  *
  * @param ptr                   Pointer to data that to be written into disk. Memory pointed should be positive integer multiple of BLOCK_SIZE
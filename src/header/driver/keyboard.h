@@ -5,6 +5,7 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "header/cpu/interrupt.h"
+#include "header/process/process.h"
 
 #define EXT_SCANCODE_UP        0x48
 #define EXT_SCANCODE_DOWN      0x50
@@ -14,6 +15,9 @@
 #define KEYBOARD_DATA_PORT     0x60
 #define EXTENDED_SCANCODE_BYTE 0xE0
 
+// Process blocked until keyboard buffer is filled, woken by keyboard ISR
+extern struct ProcessQueue _keyboard_wait_queue;
+
 
 
 
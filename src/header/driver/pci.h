@@ -0,0 +1,84 @@
+#ifndef _PCI_H
+#define _PCI_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* -- PCI configuration space mechanism #1 -- */
+#define PCI_CONFIG_ADDRESS_PIO 0xCF8
+#define PCI_CONFIG_DATA_PIO    0xCFC
+#define PCI_CONFIG_ENABLE_BIT  0x80000000
+
+#define PCI_BUS_COUNT          256
+#define PCI_DEVICE_COUNT       32
+#define PCI_FUNCTION_COUNT     8
+
+/* -- PCI configuration space header (type 0) offsets -- */
+#define PCI_OFFSET_VENDOR_ID   0x00
+#define PCI_OFFSET_COMMAND     0x04
+#define PCI_OFFSET_CLASS       0x08
+#define PCI_OFFSET_HEADER_TYPE 0x0C
+#define PCI_OFFSET_BAR4        0x20
+
+#define PCI_VENDOR_ID_INVALID          0xFFFF
+#define PCI_HEADER_TYPE_MULTI_FUNCTION 0x80
+
+#define PCI_COMMAND_IO_SPACE   0x1
+#define PCI_COMMAND_BUS_MASTER 0x4
+
+#define PCI_BAR_IO_SPACE       0x1
+#define PCI_BAR_IO_ADDRESS     0xFFFFFFFC
+
+/* -- PCI class code -- */
+#define PCI_CLASS_MASS_STORAGE    0x01
+#define PCI_SUBCLASS_IDE          0x01
+#define PCI_PROG_IF_IDE_PRIMARY_NATIVE 0x01
+#define PCI_PROG_IF_IDE_BUS_MASTER     0x80
+
+
+
+/**
+ * PCI device location in configuration space
+ * 
+ * @param bus      Bus number    [0, 255]
+ * @param device   Device number [0, 31]
+ * @param function Function number [0, 7]
+ */
+struct PCIDeviceAddress {
+    uint8_t bus;
+    uint8_t device;
+    uint8_t function;
+};
+
+
+
+/**
+ * Read 32-bit register from PCI configuration space
+ * 
+ * @param addr   Target device
+ * @param offset Register offset, will be aligned to 4 bytes
+ * @return       Register value
+ */
+uint32_t pci_config_read(struct PCIDeviceAddress addr, uint8_t offset);
+
+/**
+ * Write 32-bit register into PCI configuration space
+ * 
+ * @param addr   Target device
+ * @param offset Register offset, will be aligned to 4 bytes
+ * @param value  Value to write
+ */
+void pci_config_write(struct PCIDeviceAddress addr, uint8_t offset, uint32_t value);
+
+/**
+ * Brute-force scan all buses for first device with matching class and subclass
+ * 
+ * @param class_code Base class code
+ * @param subclass   Subclass code
+ * @param result     Pointer to store found device location
+ * @return           True if device found
+ */
+bool pci_find_device_by_class(uint8_t class_code, uint8_t subclass, struct PCIDeviceAddress *result);
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef _BUFFER_CACHE_H
+#define _BUFFER_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/filesystem/fat32.h"
+
+/* -- Buffer cache constants -- */
+#define BUFFER_CACHE_ENTRY_COUNT        64
+#define BUFFER_CACHE_HASH_BUCKET_COUNT  128
+#define BUFFER_CACHE_INVALID_INDEX      -1
+// Timer tick count between periodic write-back, with 1000 Hz timer this is 1 second
+#define BUFFER_CACHE_WRITEBACK_INTERVAL 1000
+// buffer_cache_writeback_next_tick() return value if nothing is dirty
+#define BUFFER_CACHE_NO_WRITEBACK       0xFFFFFFFF
+
+
+
+/**
+ * Single cached cluster. Dirty tracking is done per block to avoid rewriting whole cluster
+ * 
+ * @param cluster_number   Cached cluster number
+ * @param valid            Whether this entry is holding any cluster
+ * @param dirty_block_mask Bit i set if block i in cluster is modified but not yet written back
+ * @param hash_next        Next entry index in same hash bucket
+ * @param lru_prev         More recently used entry index
+ * @param lru_next         Less recently used entry index
+ * @param data             Cluster content
+ */
+struct BufferCacheEntry {
+    uint32_t             cluster_number;
+    bool                 valid;
+    uint8_t              dirty_block_mask;
+    int16_t              hash_next;
+    int16_t              lru_prev;
+    int16_t              lru_next;
+    struct ClusterBuffer data;
+};
+
+/**
+ * Buffer cache counters, used for sizing BUFFER_CACHE_ENTRY_COUNT
+ * 
+ * @param hit       Access served from cache
+ * @param miss      Access that require reading cluster from disk
+ * @param writeback Dirty cluster written into disk
+ * @param eviction  Valid entry replaced for another cluster
+ */
+struct BufferCacheStatistic {
+    uint32_t hit;
+    uint32_t miss;
+    uint32_t writeback;
+    uint32_t eviction;
+};
+
+
+
+/* -- Buffer cache interfaces -- */
+/**
+ * Read single cluster through buffer cache. Will read from disk on miss
+ * 
+ * @param ptr            Pointer to buffer with size at least CLUSTER_SIZE
+ * @param cluster_number Cluster to read
+ */
+void buffer_cache_read(void *ptr, uint32_t cluster_number);
+
+/**
+ * Write single cluster into buffer cache and mark it dirty. 
+ * Disk will be updated on eviction, periodic write-back, or buffer_cache_sync()
+ * 
+ * @param ptr            Pointer to source data with size CLUSTER_SIZE
+ * @param cluster_number Cluster to write
+ */
+void buffer_cache_write(const void *ptr, uint32_t cluster_number);
+
+/**
+ * Get pointer into cached cluster content for in-place access, loading it if needed.
+ * Pointer only valid until next buffer cache operation
+ * 
+ * @param cluster_number Cluster to get
+ * @return               Pointer to CLUSTER_SIZE bytes of cached cluster
+ */
+void* buffer_cache_get(uint32_t cluster_number);
+
+/**
+ * Mark part of cached cluster as modified after in-place access with buffer_cache_get()
+ * 
+ * @param cluster_number Modified cluster, must be already cached
+ * @param offset         Byte offset inside cluster
+ * @param size           Modified size in bytes
+ */
+void buffer_cache_mark_dirty(uint32_t cluster_number, uint32_t offset, uint32_t size);
+
+/**
+ * Copy cached cluster into ptr if it is dirty. Used after reading cluster directly from disk
+ * 
+ * @param ptr            Pointer to already read cluster with size CLUSTER_SIZE
+ * @param cluster_number Cluster number of ptr content
+ */
+void buffer_cache_overlay_dirty(void *ptr, uint32_t cluster_number);
+
+/**
+ * Replace cached cluster content and mark it clean. Used after writing cluster directly into disk
+ * 
+ * @param ptr            Pointer to written data with size CLUSTER_SIZE
+ * @param cluster_number Cluster number written
+ */
+void buffer_cache_refresh(const void *ptr, uint32_t cluster_number);
+
+// Write all dirty blocks into disk, periodic write-back interval restart
+void buffer_cache_sync(void);
+
+/**
+ * Count timer tick for periodic write-back
+ * 
+ * @param tick Elapsed timer tick
+ */
+void buffer_cache_tick(uint32_t tick);
+
+/**
+ * Check periodic write-back, interval restart if nothing is dirty
+ * 
+ * @return True if BUFFER_CACHE_WRITEBACK_INTERVAL elapsed since last write-back and dirty blocks exist
+ */
+bool buffer_cache_writeback_due(void);
+
+/**
+ * Timer tick until periodic write-back is due, for tickless timer
+ * 
+ * @return 0 if already due, BUFFER_CACHE_NO_WRITEBACK if nothing is dirty
+ */
+uint32_t buffer_cache_writeback_next_tick(void);
+
+// Get copy of buffer cache counters
+struct BufferCacheStatistic buffer_cache_get_statistic(void);
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef _DIRECTORY_INDEX_H
+#define _DIRECTORY_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* -- Directory index constants -- */
+#define DIRECTORY_INDEX_DIRECTORY_COUNT 16
+#define DIRECTORY_INDEX_NODE_COUNT      4096
+// Must be power of two
+#define DIRECTORY_INDEX_BUCKET_COUNT    1024
+#define DIRECTORY_INDEX_INVALID_INDEX   -1
+
+
+
+/**
+ * Single indexed directory entry, chained by hash of (directory cluster, name, ext)
+ *
+ * @param name            Entry name
+ * @param ext             Entry extension
+ * @param directory_slot  Owner DirectoryIndexDirectory index
+ * @param hash_next       Next node index in same hash bucket, or next free node
+ * @param entry_index     Entry index inside directory
+ */
+struct DirectoryIndexNode {
+    char     name[8];
+    char     ext[3];
+    uint8_t  directory_slot;
+    int16_t  hash_next;
+    uint32_t entry_index;
+};
+
+/**
+ * Indexed directory, every non-empty entry of directory have single DirectoryIndexNode
+ *
+ * @param cluster_number First cluster of directory
+ * @param valid          Whether this slot is holding any directory
+ * @param overflow       Directory entry count exceed node pool, slot only remember not to index it again
+ * @param free_hint      Lower bound of empty entry index, all entries below this are not empty
+ * @param node_count     Node owned by this directory
+ * @param last_access    Access counter value when last used, for LRU eviction
+ */
+struct DirectoryIndexDirectory {
+    uint32_t cluster_number;
+    bool     valid;
+    bool     overflow;
+    uint32_t free_hint;
+    uint32_t node_count;
+    uint32_t last_access;
+};
+
+
+
+/* -- Directory index interfaces -- */
+// Drop all indexed directory, used when file system is (re)initialized
+void directory_index_reset(void);
+
+// Toggle directory index usage, useful for comparing with linear scan - @param enable Drop all index if false
+void directory_index_set_enable(bool enable);
+
+/**
+ * Check whether directory is already indexed
+ *
+ * @param dir_cluster First cluster of directory
+ * @return True if lookup on this directory can be served by index
+ */
+bool directory_index_is_loaded(uint32_t dir_cluster);
+
+/**
+ * Start indexing directory, evicting least recently used directory if needed.
+ * Caller should insert every non-empty entry afterward
+ *
+ * @param dir_cluster First cluster of directory
+ * @return False if directory index is disabled or directory is marked overflow
+ */
+bool directory_index_begin(uint32_t dir_cluster);
+
+/**
+ * Insert entry into directory index. No-op if directory is not indexed or name already exist.
+ * If node pool is exhausted by this directory alone, directory index is dropped and marked overflow
+ *
+ * @param dir_cluster First cluster of directory
+ * @param name        Entry name
+ * @param ext         Entry extension
+ * @param entry_index Entry index inside directory
+ * @return False if directory index is dropped
+ */
+bool directory_index_insert(uint32_t dir_cluster, const char name[8], const char ext[3], uint32_t entry_index);
+
+/**
+ * Remove entry from directory index and lower free_hint. No-op if directory is not indexed
+ *
+ * @param dir_cluster First cluster of directory
+ * @param name        Entry name
+ * @param ext         Entry extension
+ */
+void directory_index_remove(uint32_t dir_cluster, const char name[8], const char ext[3]);
+
+/**
+ * Search entry in indexed directory
+ *
+ * @param dir_cluster First cluster of directory, must be already loaded
+ * @param name        Entry name
+ * @param ext         Entry extension
+ * @return int32_t entry_index, -1 if not found
+ */
+int32_t directory_index_lookup(uint32_t dir_cluster, const char name[8], const char ext[3]);
+
+/**
+ * Get lower bound of empty entry index, all entries below hint are not empty
+ *
+ * @param dir_cluster First cluster of directory, must be already loaded
+ * @return uint32_t Entry index to start searching empty entry
+ */
+uint32_t directory_index_get_free_hint(uint32_t dir_cluster);
+
+/**
+ * Raise free hint after caller scanned non-empty entries. No-op if directory is not indexed
+ *
+ * @param dir_cluster First cluster of directory
+ * @param free_hint   New lower bound of empty entry index
+ */
+void directory_index_set_free_hint(uint32_t dir_cluster, uint32_t free_hint);
+
+/**
+ * Drop directory index, must be called when directory cluster is freed
+ *
+ * @param dir_cluster First cluster of directory
+ */
+void directory_index_invalidate(uint32_t dir_cluster);
+
+#endif
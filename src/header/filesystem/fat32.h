@@ -7,9 +7,12 @@
 #define BOOT_SECTOR                 0
 #define CLUSTER_BLOCK_COUNT         4
 #define CLUSTER_SIZE                (BLOCK_SIZE*CLUSTER_BLOCK_COUNT)
+// FAT entry count per FAT cluster
 #define CLUSTER_MAP_SIZE            512
 #define DIRECTORY_TABLE_ENTRY_COUNT (CLUSTER_SIZE / sizeof(struct FAT32DirectoryEntry))
 #define CLUSTER_MARK_MAX            512
+// Maximum cluster count per read_clusters() / write_clusters(), limited by uint8_t block_count
+#define CLUSTER_CONTIGUOUS_MAX      (255 / CLUSTER_BLOCK_COUNT)
 
 /* -- FAT32 FileAllocationTable constants -- */
 // FAT reserved value for cluster 0 and 1 in FileAllocationTable
@@ -23,6 +26,11 @@
 #define FAT_CLUSTER_NUMBER    1
 #define ROOT_CLUSTER_NUMBER   2
 
+// Maximum addressable cluster, 256K * 2 KiB = 512 MiB of storage
+#define FAT32_CLUSTER_COUNT_MAX (256*1024)
+// FAT32Geometry location inside boot sector, outside of signature text
+#define FS_GEOMETRY_OFFSET      0x100
+
 /* -- FAT32 DirectoryEntry constants -- */
 #define ATTR_SUBDIRECTORY     0b00010000
 #define UATTR_NOT_EMPTY       0b10101010
@@ -45,6 +53,7 @@ struct ClusterBuffer {
 
 /**
  * FAT32 FileAllocationTable, for more information about this, check guidebook
+ * FAT may span multiple cluster, this struct represent single FAT cluster
  *
  * @param cluster_map Containing cluster map of FAT32
  */
@@ -52,6 +61,18 @@ struct FAT32FileAllocationTable {
     uint32_t cluster_map[CLUSTER_MAP_SIZE];
 } __attribute__((packed));
 
+/**
+ * FAT32Geometry - File system size, stored in boot sector at FS_GEOMETRY_OFFSET.
+ * Zeroed geometry is treated as legacy single cluster FAT with CLUSTER_MAP_SIZE cluster
+ *
+ * @param cluster_count     Total cluster in file system
+ * @param fat_cluster_count FAT size in cluster, FAT cluster k > 0 is located at ROOT_CLUSTER_NUMBER + k
+ */
+struct FAT32Geometry {
+    uint32_t cluster_count;
+    uint32_t fat_cluster_count;
+} __attribute__((packed));
+
 /**
  * FAT32 standard 8.3 format - 32 bytes DirectoryEntry, Some detail can be found at:
  * https://en.wikipedia.org/wiki/Design_of_the_FAT_file_system#Directory_entry, and click show table.
@@ -91,6 +112,8 @@ struct FAT32DirectoryEntry {
 } __attribute__((packed));
 
 // FAT32 DirectoryTable, containing directory entry table - @param table Table of DirectoryEntry that span within 1 cluster
+// Directory may span multiple DirectoryTable chained with FAT, entry_index i is located at table[i % DIRECTORY_TABLE_ENTRY_COUNT]
+// of (i / DIRECTORY_TABLE_ENTRY_COUNT)-th cluster in chain. Self and parent entry only exist in first cluster
 struct FAT32DirectoryTable {
     struct FAT32DirectoryEntry table[DIRECTORY_TABLE_ENTRY_COUNT];
 } __attribute__((packed));
@@ -104,14 +127,20 @@ struct FAT32DirectoryTable {
 /**
  * FAT32DriverState - Contain all driver states
  * 
- * @param fat_table     FAT of the system, will be loaded during initialize_filesystem_fat32()
- * @param dir_table_buf Buffer for directory table 
- * @param cluster_buf   Buffer for cluster
+ * @param cluster_count       Total cluster in file system, loaded from FAT32Geometry
+ * @param fat_cluster_count   FAT size in cluster, FAT itself is accessed through buffer cache
+ * @param dir_table_buf       Buffer for directory table 
+ * @param cluster_buf         Buffer for cluster
+ * @param free_cluster_bitmap Bit set if cluster is empty, derived from FAT for extent searching
+ * @param free_cluster_count  Empty cluster count in FAT
  */
 struct FAT32DriverState {
-    struct FAT32FileAllocationTable fat_table;
+    uint32_t                        cluster_count;
+    uint32_t                        fat_cluster_count;
     struct FAT32DirectoryTable      dir_table_buf;
     struct ClusterBuffer            cluster_buf;
+    uint32_t                        free_cluster_bitmap[FAT32_CLUSTER_COUNT_MAX / 32];
+    uint32_t                        free_cluster_count;
 } __attribute__((packed));
 
 /**
@@ -158,40 +187,42 @@ void init_directory_table(struct FAT32DirectoryTable *dir_table, char *name, uin
 /**
  * Checking whether filesystem signature is missing or not in boot sector
  * 
- * @return True if memcmp(boot_sector, fs_signature) returning inequality
+ * @return True if memcmp(boot_sector, fs_signature) returning inequality, FAT32Geometry bytes are excluded
  */
 bool is_empty_storage(void);
 
 /**
- * Create new FAT32 file system. Will write fs_signature into boot sector and 
- * proper FileAllocationTable that contain CLUSTER_0_VALUE, CLUSTER_1_VALUE, 
- * and initialized root directory
+ * Create new FAT32 file system. Will write fs_signature with FAT32Geometry sized from disk_get_block_count()
+ * into boot sector and proper FileAllocationTable that contain CLUSTER_0_VALUE, CLUSTER_1_VALUE, 
+ * FAT clusters, and initialized root directory
  */
 void create_fat32(void);
 
 /**
  * Initialize file system driver state, if is_empty_storage() then create_fat32()
- * Else, read and cache entire FileAllocationTable into driver state
+ * Else, read FAT32Geometry and build free cluster bitmap from FileAllocationTable
  */
 void initialize_filesystem_fat32(void);
 
 /**
- * Write cluster operation, wrapper for write_blocks().
+ * Write cluster operation through buffer cache, disk is updated later with write_blocks().
+ * Multi-cluster write bypass buffer cache and issue single write_blocks().
  * Recommended to use struct ClusterBuffer
  * 
  * @param ptr            Pointer to source data
  * @param cluster_number Cluster number to write
- * @param cluster_count  Cluster count to write, due limitation of write_blocks block_count 255 => max cluster_count = 63
+ * @param cluster_count  Cluster count to write, due limitation of write_blocks block_count 255 => max cluster_count = CLUSTER_CONTIGUOUS_MAX
  */
 void write_clusters(const void *ptr, uint32_t cluster_number, uint8_t cluster_count);
 
 /**
- * Read cluster operation, wrapper for read_blocks().
+ * Read cluster operation through buffer cache, wrapper for read_blocks() on cache miss.
+ * Multi-cluster read bypass buffer cache and issue single read_blocks().
  * Recommended to use struct ClusterBuffer
  * 
  * @param ptr            Pointer to buffer for reading
  * @param cluster_number Cluster number to read
- * @param cluster_count  Cluster count to read, due limitation of read_blocks block_count 255 => max cluster_count = 63
+ * @param cluster_count  Cluster count to read, due limitation of read_blocks block_count 255 => max cluster_count = CLUSTER_CONTIGUOUS_MAX
  */
 void read_clusters(void *ptr, uint32_t cluster_number, uint8_t cluster_count);
 
@@ -217,20 +248,72 @@ bool is_loaded_dir_table_valid(void);
 uint32_t get_cluster_from_entry(struct FAT32DirectoryEntry entry);
 
 /**
- * Search single entry index with same name or just single empty entry
- * Note : Stateful - Require fat32driver_state.dirtable already loaded properly
+ * Search single entry index with same name by walking whole directory chain
+ * Note : Stateful - Found entry cluster is left loaded in fat32driver_state.dir_table_buf
+ *
+ * @param dir_cluster   First cluster of directory
+ * @param name          Name to match
+ * @param ext           Extension to match
+ * @param entry_cluster Pointer to store cluster holding found entry
+ * @return int32_t entry_index in directory, -1 if not found
+ */
+int32_t driver_dir_table_linear_scan(uint32_t dir_cluster, char name[8], char ext[3], uint32_t *entry_cluster);
+
+/**
+ * Search entry index with same name through directory index, built from directory chain on first access.
+ * Fallback into driver_dir_table_linear_scan() if directory index is unavailable
+ * Note : Stateful - Found entry cluster is left loaded in fat32driver_state.dir_table_buf
+ *
+ * @param dir_cluster   First cluster of directory
+ * @param name          Name to match
+ * @param ext           Extension to match
+ * @param entry_cluster Pointer to store cluster holding found entry
+ * @return int32_t entry_index in directory, -1 if not found
+ */
+int32_t driver_dir_table_lookup(uint32_t dir_cluster, char name[8], char ext[3], uint32_t *entry_cluster);
+
+/**
+ * Search empty entry index, starting from directory index free hint.
+ * If every cluster is full, new empty cluster is chained into directory
+ * Note : Stateful - Found entry cluster is left loaded in fat32driver_state.dir_table_buf
+ *
+ * @param dir_cluster   First cluster of directory
+ * @param entry_cluster Pointer to store cluster holding empty entry
+ * @return int32_t entry_index in directory, -1 if no empty cluster available
+ */
+int32_t driver_dir_table_find_empty(uint32_t dir_cluster, uint32_t *entry_cluster);
+
+/**
+ * Get FAT entry value, FAT cluster is accessed lazily through buffer cache
+ *
+ * @param cluster_number Cluster number to look up
+ * @return uint32_t FAT entry of cluster_number
+ */
+uint32_t driver_fat_get_entry(uint32_t cluster_number);
+
+/**
+ * Set FAT entry value and free cluster bitmap. Only the FAT block containing entry is marked dirty
+ *
+ * @param cluster_number Cluster number to update
+ * @param value          New FAT entry value
+ */
+void driver_fat_set_entry(uint32_t cluster_number, uint32_t value);
+
+/**
+ * Search smallest contiguous empty cluster extent (best-fit) with length at least cluster_count
+ * Note : Stateful - Require fat32driver_state.free_cluster_bitmap
  *
- * @param name       Name to match
- * @param ext        Extension to match
- * @param find_empty Whether searching empty entry or not
- * @return int32_t entry_index in dirtable, -1 if not found
+ * @param cluster_count How many contiguous empty cluster needed
+ * @param start_cluster Pointer to store first cluster of found extent
+ * @return True if extent found
  */
-int32_t driver_dir_table_linear_scan(char name[8], char ext[3], bool find_empty);
+bool driver_fat_find_contiguous_cluster(uint32_t cluster_count, uint32_t *start_cluster);
 
 /**
  * Mark empty cluster_map (up to CLUSTER_MARK_MAX clusters) and put cluster_number in empty_buf.
- * Will try to search cluster_count-many empty FAT entry.
- * Note : Stateful - Require fat32driver_state.dirtable already loaded properly
+ * Will try to search cluster_count-many empty FAT entry, preferring single contiguous extent
+ * and fallback to first empty clusters if free space is fragmented.
+ * Note : Stateful - Require fat32driver_state.free_cluster_bitmap
  *
  * @param empty_buf     Pointer into array with size at least uint32_t[CLUSTER_MARK_MAX]
  * @param cluster_count How many empty cluster to search
@@ -246,6 +329,34 @@ int8_t driver_fat_mark_empty_cluster(uint32_t empty_buf[CLUSTER_MARK_MAX], uint3
  */
 bool is_dirtable_empty(struct FAT32DirectoryTable *dirtable);
 
+/**
+ * Copy directory entry at entry_index, walking directory chain
+ *
+ * @param dir_cluster First cluster of directory
+ * @param entry_index Entry index in directory
+ * @param entry       Pointer to store entry
+ * @return int8_t Error code, -1 if entry_index is beyond directory chain
+ */
+int8_t driver_dir_get_entry(uint32_t dir_cluster, uint32_t entry_index, struct FAT32DirectoryEntry *entry);
+
+/**
+ * Overwrite directory entry at entry_index, walking directory chain
+ *
+ * @param dir_cluster First cluster of directory
+ * @param entry_index Entry index in directory
+ * @param entry       New entry value
+ * @return int8_t Error code, -1 if entry_index is beyond directory chain
+ */
+int8_t driver_dir_set_entry(uint32_t dir_cluster, uint32_t entry_index, struct FAT32DirectoryEntry entry);
+
+/**
+ * Append single empty cluster after last_cluster, physically next cluster is preferred
+ *
+ * @param last_cluster Last cluster in chain, FAT entry must be FAT32_FAT_END_OF_FILE
+ * @return uint32_t New last cluster, FAT32_FAT_EMPTY_ENTRY if storage is full
+ */
+uint32_t driver_fat_extend_chain(uint32_t last_cluster);
+
 
 
 
@@ -254,11 +365,12 @@ bool is_dirtable_empty(struct FAT32DirectoryTable *dirtable);
 /**
  *  FAT32 Folder / Directory read
  *
- * @param request buf point to struct FAT32DirectoryTable,
+ * @param request buf point to array of struct FAT32DirectoryTable,
  *                name is directory name,
  *                ext is unused,
  *                parent_cluster_number is target directory table to read,
- *                buffer_size must be exactly sizeof(struct FAT32DirectoryTable)
+ *                buffer_size is multiple of sizeof(struct FAT32DirectoryTable), directory chain is read until buffer is full.
+ *                First cluster is always read, unused table is zeroed
  * @return Error code: 0 success - 1 not a folder - 2 not found - -1 unknown
  */
 int8_t read_directory(struct FAT32DriverRequest request);
@@ -289,4 +401,23 @@ int8_t write(struct FAT32DriverRequest request);
  */
 int8_t delete(struct FAT32DriverRequest request);
 
-#endif
\ No newline at end of file
+
+
+/* -- Defragmentation -- */
+/**
+ * Relocate fragmented file cluster chain into single contiguous extent
+ *
+ * @param request name, ext, and parent_cluster_number will be used, buf and buffer_size is unused
+ * @return Error code: 0 success - 1 not a file - 2 not enough contiguous space - 3 not found - -1 unknown
+ */
+int8_t defragment(struct FAT32DriverRequest request);
+
+/**
+ * Defragmentation pass for all files, walking directory tree from root directory.
+ * Files that cannot fit into any contiguous extent is left as is
+ *
+ * @return Relocated file count
+ */
+uint32_t defragment_all(void);
+
+#endif
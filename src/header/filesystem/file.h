@@ -0,0 +1,149 @@
+#ifndef _FILE_H
+#define _FILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/filesystem/fat32.h"
+
+/* -- File handle constants -- */
+#define FILE_HANDLE_COUNT_MAX 32
+
+// Open mode flag for file_open()
+#define FILE_MODE_READ   0b0001
+#define FILE_MODE_WRITE  0b0010
+#define FILE_MODE_CREATE 0b0100
+#define FILE_MODE_APPEND 0b1000
+
+// Whence for file_seek()
+#define FILE_SEEK_SET 0
+#define FILE_SEEK_CUR 1
+#define FILE_SEEK_END 2
+
+// Negative return code for file_open(), non-negative value is file handle
+#define FILE_OPEN_FAIL_HANDLE_EXCEEDED -1
+#define FILE_OPEN_FAIL_INVALID_PARENT  -2
+#define FILE_OPEN_FAIL_NOT_FOUND       -3
+#define FILE_OPEN_FAIL_IS_DIRECTORY    -4
+#define FILE_OPEN_FAIL_CREATE          -5
+
+
+
+/**
+ * Opened file state. Cursor cluster cache position so sequential access never re-walk FAT chain.
+ * Note : Handles to same file are not coherent with each other, and opened file should not be deleted / defragmented
+ *
+ * @param used                 Whether this handle is opened
+ * @param owner                Owner process ID, used for handle validation & cleanup
+ * @param mode                 Combination of FILE_MODE_* flag
+ * @param parent_cluster       Parent directory cluster, for updating filesize
+ * @param entry_index          Entry index in parent directory
+ * @param first_cluster        First cluster of file
+ * @param filesize             File size in bytes
+ * @param offset               Byte offset for next read / write
+ * @param cursor_cluster       Cached cluster number of cursor_cluster_index-th cluster in chain
+ * @param cursor_cluster_index Position of cursor_cluster in chain
+ */
+struct FileHandle {
+    bool     used;
+    uint32_t owner;
+    uint8_t  mode;
+    uint32_t parent_cluster;
+    uint32_t entry_index;
+    uint32_t first_cluster;
+    uint32_t filesize;
+    uint32_t offset;
+    uint32_t cursor_cluster;
+    uint32_t cursor_cluster_index;
+};
+
+/**
+ * FileRequest - Request for file handle syscall
+ *
+ * @param fd     File handle returned by file_open()
+ * @param buf    Pointer to buffer, used for read & write
+ * @param size   Byte count to read / write
+ * @param offset Seek offset relative to whence
+ * @param whence FILE_SEEK_SET, FILE_SEEK_CUR, or FILE_SEEK_END
+ */
+struct FileRequest {
+    int32_t  fd;
+    void    *buf;
+    uint32_t size;
+    int32_t  offset;
+    uint8_t  whence;
+} __attribute__((packed));
+
+
+
+/* -- File handle interfaces -- */
+/**
+ * Open file, file handle offset start from 0
+ *
+ * @param request name, ext, and parent_cluster_number of file. buf and buffer_size is unused
+ * @param mode    Combination of FILE_MODE_* flag, FILE_MODE_CREATE will create empty file if not found
+ * @param owner   Owner process ID
+ * @return int32_t File handle, or negative FILE_OPEN_FAIL_* error code
+ */
+int32_t file_open(struct FAT32DriverRequest request, uint8_t mode, uint32_t owner);
+
+/**
+ * Read up to size bytes from file handle offset and advance offset
+ *
+ * @param fd   File handle
+ * @param buf  Pointer to buffer with size at least size
+ * @param size Maximum byte count to read
+ * @return int32_t Byte count read, 0 on end of file, -1 if handle invalid or not readable
+ */
+int32_t file_read(int32_t fd, void *buf, uint32_t size);
+
+/**
+ * Write size bytes into file handle offset and advance offset, file is grown as needed.
+ * With FILE_MODE_APPEND, offset is moved into end of file before writing
+ *
+ * @param fd   File handle
+ * @param buf  Pointer to source data
+ * @param size Byte count to write
+ * @return int32_t Byte count written, lower than size if storage is full, -1 if handle invalid or not writable
+ */
+int32_t file_write(int32_t fd, const void *buf, uint32_t size);
+
+/**
+ * Move file handle offset, offset beyond end of file is not allowed
+ *
+ * @param fd     File handle
+ * @param offset Offset relative to whence
+ * @param whence FILE_SEEK_SET, FILE_SEEK_CUR, or FILE_SEEK_END
+ * @return int32_t New offset, -1 if handle invalid or resulting offset out of file
+ */
+int32_t file_seek(int32_t fd, int32_t offset, uint8_t whence);
+
+/**
+ * Close file handle
+ *
+ * @param fd File handle
+ * @return int8_t Error code, -1 if handle invalid
+ */
+int8_t file_close(int32_t fd);
+
+/**
+ * Get first cluster of opened file, identify file content for image cache
+ *
+ * @param fd File handle
+ * @return uint32_t First cluster, 0 if handle invalid
+ */
+uint32_t file_get_first_cluster(int32_t fd);
+
+/**
+ * Check whether file handle is opened by owner
+ *
+ * @param fd    File handle
+ * @param owner Process ID
+ * @return True if handle valid and owned
+ */
+bool file_is_owned(int32_t fd, uint32_t owner);
+
+// Close every file handle opened by owner - @param owner Process ID
+void file_close_all(uint32_t owner);
+
+#endif
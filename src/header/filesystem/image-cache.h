@@ -0,0 +1,87 @@
+#ifndef _IMAGE_CACHE_H
+#define _IMAGE_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* -- Image cache constants -- */
+#define IMAGE_CACHE_HASH_BUCKET_COUNT 64
+// Never returned by image_cache_lookup() for cached page, physical address 0 is kernel reserved
+#define IMAGE_CACHE_MISS              0
+
+
+
+/**
+ * Resident executable page, shared read-only by every process that run the same file.
+ * Cache hold single frame reference, process mapping hold the others
+ * 
+ * @param first_cluster First cluster of executable file, identify the file
+ * @param page_offset   Page start address relative to image base, page content is also zero-filled outside file
+ * @param physical_addr Page frame physical address
+ * @param next          Next entry in same hash bucket
+ */
+struct ImageCacheEntry {
+    uint32_t               first_cluster;
+    uint32_t               page_offset;
+    uint32_t               physical_addr;
+    struct ImageCacheEntry *next;
+};
+
+/**
+ * Image cache counters
+ * 
+ * @param hit          Page mapped from cache without reading file
+ * @param miss         Page read from file
+ * @param entry_count  Cached page count
+ * @param invalidation Entry dropped because file content changed
+ * @param shrink       Entry dropped to release memory
+ */
+struct ImageCacheStatistic {
+    uint32_t hit;
+    uint32_t miss;
+    uint32_t entry_count;
+    uint32_t invalidation;
+    uint32_t shrink;
+};
+
+
+
+/* -- Image cache interfaces -- */
+/**
+ * Find cached executable page. Reference is added for returned frame, caller must map or frame_free() it
+ * 
+ * @param first_cluster First cluster of executable
+ * @param page_offset   Page start address relative to image base
+ * @return              Page frame physical address, IMAGE_CACHE_MISS if not cached
+ */
+uint32_t image_cache_lookup(uint32_t first_cluster, uint32_t page_offset);
+
+/**
+ * Cache freshly loaded executable page, cache add its own frame reference.
+ * Frame content must not be modified afterward, process should map it copy-on-write
+ * 
+ * @param first_cluster First cluster of executable
+ * @param page_offset   Page start address relative to image base
+ * @param physical_addr Page frame physical address
+ */
+void image_cache_insert(uint32_t first_cluster, uint32_t page_offset, uint32_t physical_addr);
+
+/**
+ * Drop every cached page of file, called when file content is modified or its clusters are released
+ * 
+ * @param first_cluster First cluster of file
+ */
+void image_cache_invalidate(uint32_t first_cluster);
+
+/**
+ * Drop cached page that is not mapped by any process
+ * 
+ * @return Released page frame count
+ */
+uint32_t image_cache_shrink(void);
+
+// Get copy of image cache counters - @return ImageCacheStatistic
+struct ImageCacheStatistic image_cache_get_statistic(void);
+
+#endif
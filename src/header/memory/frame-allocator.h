@@ -0,0 +1,152 @@
+#ifndef _FRAME_ALLOCATOR_H
+#define _FRAME_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/memory/paging.h"
+
+/* -- Frame allocator constants -- */
+// Largest block is 2^FRAME_ORDER_MAX page frame = 4 MiB
+#define FRAME_ORDER_MAX          10
+#define FRAME_ORDER_COUNT        (FRAME_ORDER_MAX + 1)
+// Physical memory beyond this is ignored, limited by direct map size and static metadata
+#define FRAME_MEMORY_MAX_MB      512
+#define FRAME_MAX_COUNT          ((FRAME_MEMORY_MAX_MB << 20) / PAGE_FRAME_SIZE)
+// Sum of FRAME_MAX_COUNT >> order for every order, in 32-bit word
+#define FRAME_BITMAP_WORD_COUNT  (2 * FRAME_MAX_COUNT / 32)
+#define FRAME_INVALID_INDEX      0xFFFFFFFF
+// Available region taken from multiboot memory map
+#define FRAME_MEMORY_REGION_MAX  32
+// Physical address 0 is kernel reserved, never returned by frame_allocate()
+#define FRAME_ALLOCATE_FAIL      0
+
+// Multiboot constants, refer to Multiboot Specification version 0.6.96
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+#define MULTIBOOT_INFO_MEMORY      0x001
+#define MULTIBOOT_INFO_MEMORY_MAP  0x040
+#define MULTIBOOT_MEMORY_AVAILABLE 1
+
+
+
+/**
+ * Multiboot information structure passed by bootloader in ebx, only fields up to memory map is used
+ *
+ * @param flags       Validity of every following field, MULTIBOOT_INFO_*
+ * @param mem_lower   KiB of lower memory, starting from 0
+ * @param mem_upper   KiB of upper memory, starting from 1 MiB
+ * @param mmap_length Memory map size in bytes
+ * @param mmap_addr   Physical address of first MultibootMemoryMap
+ */
+struct MultibootInfo {
+    uint32_t flags;
+    uint32_t mem_lower;
+    uint32_t mem_upper;
+    uint32_t boot_device;
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;
+    uint32_t syms[4];
+    uint32_t mmap_length;
+    uint32_t mmap_addr;
+} __attribute__((packed));
+
+/**
+ * Single memory map entry. Entry size is variable, next entry is at (entry + size + 4)
+ *
+ * @param size      Entry size without this field
+ * @param base_addr Region physical address
+ * @param length    Region size in bytes
+ * @param type      MULTIBOOT_MEMORY_AVAILABLE for usable RAM
+ */
+struct MultibootMemoryMap {
+    uint32_t size;
+    uint64_t base_addr;
+    uint64_t length;
+    uint32_t type;
+} __attribute__((packed));
+
+/**
+ * Free block header, stored inside the free block itself through direct map
+ *
+ * @param next Next free block frame index with same order
+ * @param prev Previous free block frame index with same order
+ */
+struct FrameFreeBlock {
+    uint32_t next;
+    uint32_t prev;
+};
+
+/**
+ * Frame allocator counters for diagnostic
+ *
+ * @param memory_size_kb   Detected physical memory in KiB, capped at FRAME_MEMORY_MAX_MB
+ * @param total_frame      Page frame managed by allocator, excluding kernel reserved memory
+ * @param free_frame       Page frame not allocated
+ * @param free_block_count Free block count for every order
+ */
+struct FrameAllocatorStatistic {
+    uint32_t memory_size_kb;
+    uint32_t total_frame;
+    uint32_t free_frame;
+    uint32_t free_block_count[FRAME_ORDER_COUNT];
+};
+
+
+
+/* -- Frame allocator interfaces -- */
+/**
+ * Detect physical memory from multiboot information and release every usable frame into allocator.
+ * Fall back into SYSTEM_MEMORY_MB if bootloader did not provide memory information
+ *
+ * @note                          Direct map must already cover FRAME_MEMORY_MAX_MB
+ * @param multiboot_magic         eax value at kernel entry
+ * @param multiboot_info_phys_addr ebx value at kernel entry, physical address of MultibootInfo
+ */
+void frame_allocator_initialize(uint32_t multiboot_magic, uint32_t multiboot_info_phys_addr);
+
+/**
+ * Allocate 2^order physically contiguous page frame, aligned to its size
+ *
+ * @param order Block order, 0 for single page frame
+ * @return      Physical address of first frame, FRAME_ALLOCATE_FAIL if out of memory
+ */
+uint32_t frame_allocate(uint8_t order);
+
+/**
+ * Drop single reference of block allocated by frame_allocate().
+ * Block is released and merged with free buddy when last reference is dropped
+ *
+ * @param physical_addr Physical address returned by frame_allocate()
+ * @param order         Same order used for allocation
+ */
+void frame_free(uint32_t physical_addr, uint8_t order);
+
+/**
+ * Add reference to allocated block, for page frame shared by multiple page table.
+ * Every frame_reference_add() need matching frame_free()
+ *
+ * @param physical_addr Physical address returned by frame_allocate()
+ */
+void frame_reference_add(uint32_t physical_addr);
+
+/**
+ * Get reference count of allocated block
+ *
+ * @param physical_addr Physical address returned by frame_allocate()
+ * @return              Reference count, 1 for block that is not shared
+ */
+uint32_t frame_reference_count(uint32_t physical_addr);
+
+/**
+ * Check whether a certain amount of page frame is free
+ *
+ * @param amount Page frame count
+ * @return       True if at least amount page frame is free
+ */
+bool frame_allocate_check(uint32_t amount);
+
+// Get copy of frame allocator counters - @return FrameAllocatorStatistic
+struct FrameAllocatorStatistic frame_allocator_get_statistic(void);
+
+#endif
@@ -6,15 +6,29 @@
 #include <stddef.h>
 
 // Note: MB often referring to MiB in context of memory management
+// Assumed memory size when bootloader does not provide memory information
 #define SYSTEM_MEMORY_MB     128
 
 #define PAGE_ENTRY_COUNT     1024
-// Page Frame (PF) Size: (1 << 22) B = 4*1024*1024 B = 4 MiB
-#define PAGE_FRAME_SIZE      (1 << (2 + 10 + 10))
-// Maximum usable page frame. Default count: 128 / 4 = 32 page frame
-#define PAGE_FRAME_MAX_COUNT ((SYSTEM_MEMORY_MB << 20) / PAGE_FRAME_SIZE)
-
-// Operating system page directory, using page size PAGE_FRAME_SIZE (4 MiB)
+// Page Frame (PF) Size: (1 << 12) B = 4 KiB, mapped by PageTableEntry
+#define PAGE_FRAME_SIZE      (1 << (2 + 10))
+// Large page size: (1 << 22) B = 4 MiB, mapped directly by PageDirectoryEntry with use_pagesize_4_mb
+#define PAGE_LARGE_SIZE      (1 << (2 + 10 + 10))
+// First 4 MiB of physical memory is used by kernel image
+#define PAGE_FRAME_KERNEL_RESERVED_COUNT (PAGE_LARGE_SIZE / PAGE_FRAME_SIZE)
+
+// Whole physical memory is mapped with 4 MiB pages at higher half, physical address p is at virtual p + base
+#define PAGING_DIRECT_MAP_BASE        0xC0000000
+#define PAGING_DIRECT_MAP(phys_addr)  ((void*) ((uint32_t) (phys_addr) + PAGING_DIRECT_MAP_BASE))
+#define PAGING_DIRECT_MAP_TO_PHYSICAL(virtual_addr) ((uint32_t) (virtual_addr) - PAGING_DIRECT_MAP_BASE)
+#define PAGING_KERNEL_DIRECTORY_INDEX (PAGING_DIRECT_MAP_BASE >> 22)
+
+// Page fault error code pushed by CPU with exception 0xE
+#define PAGE_FAULT_ERROR_PRESENT 0b001
+#define PAGE_FAULT_ERROR_WRITE   0b010
+#define PAGE_FAULT_ERROR_USER    0b100
+
+// Operating system page directory, using page size PAGE_LARGE_SIZE (4 MiB)
 extern struct PageDirectory _paging_kernel_page_directory;
 
 
@@ -30,15 +44,51 @@ struct PageDirectoryEntryFlag {
     uint8_t use_pagesize_4_mb  : 1;
 } __attribute__((packed));
 
+/**
+ * Page directory entry, either mapping 4 MiB page directly (use_pagesize_4_mb)
+ * or pointing to PageTable containing 4 KiB pages
+ * 
+ * @param lower_address Physical address bit 22-31 of 4 MiB page
+ * @param table_address Physical address bit 12-31 of PageTable
+ */
 struct PageDirectoryEntry {
     struct PageDirectoryEntryFlag flag;
-    uint16_t global_page    : 1;
-    uint16_t reserved_1     : 3;
-    
-    uint16_t use_pat        : 1;
-    uint16_t higher_address : 8;
-    uint16_t reserved_2     : 1;
-    uint16_t lower_address  : 10;
+    union {
+        struct {
+            uint16_t global_page    : 1;
+            uint16_t reserved_1     : 3;
+
+            uint16_t use_pat        : 1;
+            uint16_t higher_address : 8;
+            uint16_t reserved_2     : 1;
+            uint16_t lower_address  : 10;
+        } __attribute__((packed));
+        struct {
+            uint32_t ignored_bit    : 4;
+            uint32_t table_address  : 20;
+        } __attribute__((packed));
+    } __attribute__((packed));
+} __attribute__((packed));
+
+/**
+ * Page table entry, map single 4 KiB page
+ * 
+ * @param copy_on_write Software bit, read-only page shared after fork that get private copy on write fault
+ * @param frame_address Physical address bit 12-31 of page frame
+ */
+struct PageTableEntry {
+    uint32_t present_bit       : 1;
+    uint32_t write_bit         : 1;
+    uint32_t user_bit          : 1;
+    uint32_t use_write_through : 1;
+    uint32_t disable_caching   : 1;
+    uint32_t accessed_bit      : 1;
+    uint32_t dirty_bit         : 1;
+    uint32_t use_pat           : 1;
+    uint32_t global_page       : 1;
+    uint32_t copy_on_write     : 1;
+    uint32_t available         : 2;
+    uint32_t frame_address     : 20;
 } __attribute__((packed));
 
 /**
@@ -55,9 +105,14 @@ struct PageDirectory {
     struct PageDirectoryEntry table[PAGE_ENTRY_COUNT];
 } __attribute__((packed));
 
-struct PageManagerState {
-    bool     page_frame_map[PAGE_FRAME_MAX_COUNT];
-    uint32_t free_page_frame_count;
+/**
+ * Page Table, second level of paging referenced by PageDirectoryEntry.
+ * Always allocated as single page frame, accessed through direct map
+ * 
+ * @param table Fixed-width array of PageTableEntry with size PAGE_ENTRY_COUNT
+ */
+struct PageTable {
+    struct PageTableEntry table[PAGE_ENTRY_COUNT];
 } __attribute__((packed));
 
 
@@ -91,28 +146,54 @@ void flush_single_tlb(void *virtual_addr);
 
 
 /* --- Memory Management --- */
+/**
+ * Map the rest of physical memory (up to FRAME_MEMORY_MAX_MB) into kernel higher half, entrypoint only map first 4 MiB.
+ * Also enable CR0.WP, so kernel write into copy-on-write user page fault like user write
+ */
+void paging_initialize(void);
+
+/**
+ * Map 4 MiB region containing memory-mapped I/O into kernel half at same virtual address, with caching disabled.
+ * Must be called before first process page directory is created, kernel half is copied on creation
+ * 
+ * @param physical_addr Physical address of device register, above direct map
+ * @return              Virtual address of device register, NULL if region overlap direct map
+ */
+void* paging_map_kernel_mmio(uint32_t physical_addr);
+
 /**
  * Check whether a certain amount of physical memory is available
  * 
- * @param amount Requested amount of physical memory in bytes
+ * @param amount Requested amount of page frame
  * @return       Return true when there's enough free memory available
  */
 bool paging_allocate_check(uint32_t amount);
 
 /**
- * Allocate single user page frame in page directory
+ * Allocate single 4 KiB user page frame in page directory, page table is created as needed
  * 
  * @param page_dir     Page directory to update
- * @param virtual_addr Virtual address to be allocated
- * @return             Physical address of allocated frame
+ * @param virtual_addr Virtual address to be allocated, rounded down to page frame
+ * @return             False if out of memory or virtual address is already mapped
  */
 bool paging_allocate_user_page_frame(struct PageDirectory *page_dir, void *virtual_addr);
 
 /**
- * Deallocate single user page frame in page directory
+ * Map existing page frame as read-only copy-on-write user page, page table is created as needed.
+ * Reference is added for frame, released with the page directory
  * 
  * @param page_dir      Page directory to update
- * @param virtual_addr  Virtual address to be allocated
+ * @param virtual_addr  Virtual address to map, rounded down to page frame
+ * @param physical_addr Page frame physical address
+ * @return              False if out of memory or virtual address is already mapped
+ */
+bool paging_map_shared_user_page_frame(struct PageDirectory *page_dir, void *virtual_addr, uint32_t physical_addr);
+
+/**
+ * Deallocate single 4 KiB user page frame in page directory
+ * 
+ * @param page_dir      Page directory to update
+ * @param virtual_addr  Virtual address to be deallocated
  * @return              Will return true if success, false otherwise
  */
 bool paging_free_user_page_frame(struct PageDirectory *page_dir, void *virtual_addr);
@@ -131,23 +212,40 @@ bool paging_free_user_page_frame(struct PageDirectory *page_dir, void *virtual_a
  */ 
 
 /* --- Process-related Memory Management --- */
-#define PAGING_DIRECTORY_TABLE_MAX_COUNT 32
-
 /**
- * Create new page directory prefilled with 1 page directory entry for kernel higher half mapping
+ * Create new page directory prefilled with kernel higher half mapping, allocated from frame allocator
  * 
  * @return Pointer to page directory virtual address. Return NULL if allocation failed
  */
 struct PageDirectory* paging_create_new_page_directory(void);
 
 /**
- * Free page directory and delete all page directory entry
+ * Free page directory, every user page frame and page table, then delete all page directory entry
  * 
  * @param page_dir Pointer to page directory virtual address
  * @return         True if free operation success 
  */
 bool paging_free_page_directory(struct PageDirectory* page_dir);
 
+/**
+ * Duplicate page directory for fork. Every user page frame is shared, writable page is
+ * marked read-only & copy-on-write in both page directory
+ * 
+ * @param page_dir Page directory to duplicate
+ * @return         New page directory virtual address, NULL if allocation failed
+ */
+struct PageDirectory* paging_fork_page_directory(struct PageDirectory *page_dir);
+
+/**
+ * Give page directory private writable copy of copy-on-write page.
+ * Frame is copied only if it is still shared, otherwise made writable in place
+ * 
+ * @param page_dir     Page directory that take write fault
+ * @param virtual_addr Faulting virtual address
+ * @return             False if page is not copy-on-write or out of memory
+ */
+bool paging_resolve_copy_on_write(struct PageDirectory *page_dir, void *virtual_addr);
+
 /**
  * Get currently active page directory virtual address from CR3 register
  * 
@@ -156,6 +254,33 @@ bool paging_free_page_directory(struct PageDirectory* page_dir);
  */
 struct PageDirectory* paging_get_current_page_directory_addr(void);
 
+/**
+ * Get virtual address that caused last page fault from CR2 register
+ * 
+ * @return Faulting virtual address
+ */
+void* paging_get_page_fault_addr(void);
+
+/**
+ * Translate virtual address into physical address using page directory
+ * 
+ * @param page_dir      Page directory used for translation
+ * @param virtual_addr  Virtual address to translate
+ * @param physical_addr Pointer to store translated physical address
+ * @return              False if virtual address is not mapped
+ */
+bool paging_virtual_to_physical_addr(struct PageDirectory *page_dir, void *virtual_addr, uint32_t *physical_addr);
+
+/**
+ * Translate virtual address of write destination, such as device-to-memory DMA that bypass MMU protection
+ * 
+ * @param page_dir      Page directory used for translation
+ * @param virtual_addr  Virtual address to translate
+ * @param physical_addr Pointer to store translated physical address
+ * @return              False if virtual address is not mapped, read-only, or still shared copy-on-write
+ */
+bool paging_virtual_to_writable_physical_addr(struct PageDirectory *page_dir, void *virtual_addr, uint32_t *physical_addr);
+
 /**
  * Change active page directory (indirectly trigger TLB flush for all non-global entry)
  * 
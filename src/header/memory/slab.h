@@ -0,0 +1,162 @@
+#ifndef _SLAB_H
+#define _SLAB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/memory/paging.h"
+
+/* -- Slab allocator constants -- */
+// Cache slot for kmalloc size class & slab_cache_create() caller
+#define SLAB_CACHE_COUNT_MAX     24
+#define SLAB_CACHE_NAME_LENGTH   16
+// Every slab is single page frame, slab header is placed at start of the frame
+#define SLAB_SIZE                PAGE_FRAME_SIZE
+// kmalloc size class: 16, 32, ..., 1024 bytes. Larger request is served directly by frame allocator
+#define SLAB_SIZE_CLASS_MIN      16
+#define SLAB_SIZE_CLASS_COUNT    7
+#define SLAB_SIZE_CLASS_MAX      (SLAB_SIZE_CLASS_MIN << (SLAB_SIZE_CLASS_COUNT - 1))
+#define SLAB_OBJECT_ALIGN_MIN    8
+
+
+
+/**
+ * Slab header, first bytes of every slab and every large kmalloc block.
+ * kfree() find header by rounding pointer down into page frame
+ *
+ * @param cache       Owner cache, NULL for large kmalloc block
+ * @param next        Next slab in cache list
+ * @param prev        Previous slab in cache list
+ * @param free_object First free object, free objects are linked through word at cache link_offset
+ * @param in_use      Allocated object count in this slab
+ * @param large_order Frame allocator order of large kmalloc block
+ */
+struct SlabHeader {
+    struct SlabCache  *cache;
+    struct SlabHeader *next;
+    struct SlabHeader *prev;
+    void              *free_object;
+    uint32_t          in_use;
+    uint32_t          large_order;
+};
+
+/**
+ * Slab cache counters
+ *
+ * @param name          Cache name
+ * @param object_size   Object size including alignment padding
+ * @param slab_count    Slab (page frame) owned by cache
+ * @param object_total  Object capacity of all slabs
+ * @param object_in_use Allocated object count
+ * @param alloc_count   Total allocation since boot, allocation rate is its difference between samples
+ * @param free_count    Total free since boot
+ */
+struct SlabCacheStatistic {
+    char     name[SLAB_CACHE_NAME_LENGTH];
+    uint32_t object_size;
+    uint32_t slab_count;
+    uint32_t object_total;
+    uint32_t object_in_use;
+    uint32_t alloc_count;
+    uint32_t free_count;
+};
+
+/**
+ * Object cache, objects are kept in constructed state while they are free.
+ * Slab lists are ordered by fullness, allocation take from partial slab first
+ *
+ * @param used          Whether this cache slot is created
+ * @param object_size   Object stride including free link & alignment padding
+ * @param object_offset First object offset from slab start
+ * @param link_offset   Free link offset inside object, placed after object content if cache has constructor
+ * @param slab_capacity Object count per slab
+ * @param constructor   Called once for every object when slab is created, may be NULL
+ * @param partial       Slab list with some free objects
+ * @param full          Slab list without free object
+ * @param empty         Slab list without allocated object, kept for reuse
+ * @param statistic     Cache counters
+ */
+struct SlabCache {
+    bool                      used;
+    uint32_t                  object_size;
+    uint32_t                  object_offset;
+    uint32_t                  link_offset;
+    uint32_t                  slab_capacity;
+    void                      (*constructor)(void *object);
+    struct SlabHeader         *partial;
+    struct SlabHeader         *full;
+    struct SlabHeader         *empty;
+    struct SlabCacheStatistic statistic;
+};
+
+/**
+ * Kernel heap counters. Internal fragmentation is 1 - requested_bytes / allocated_bytes,
+ * slab utilization is object_in_use / object_total of every cache
+ *
+ * @param cache_count        Created cache count, cache[0 ... cache_count-1] is valid
+ * @param cache              Statistic of every cache
+ * @param requested_bytes    Sum of kmalloc() size since boot
+ * @param allocated_bytes    Sum of size actually reserved for kmalloc() since boot
+ * @param large_alloc_count  kmalloc() served by frame allocator since boot
+ * @param large_frame_in_use Page frame currently held by large kmalloc block
+ * @param empty_slab_freed   Empty slab returned into frame allocator
+ */
+struct SlabStatistic {
+    uint32_t                  cache_count;
+    struct SlabCacheStatistic cache[SLAB_CACHE_COUNT_MAX];
+    uint64_t                  requested_bytes;
+    uint64_t                  allocated_bytes;
+    uint32_t                  large_alloc_count;
+    uint32_t                  large_frame_in_use;
+    uint32_t                  empty_slab_freed;
+};
+
+
+
+/* -- Slab allocator interfaces -- */
+/**
+ * Create object cache backed by frame allocator
+ *
+ * @param name        Cache name for statistic, truncated into SLAB_CACHE_NAME_LENGTH - 1
+ * @param object_size Object size in bytes, at most SLAB_SIZE / 2
+ * @param align       Object alignment, power of two. 0 for SLAB_OBJECT_ALIGN_MIN
+ * @param constructor Object constructor, may be NULL
+ * @return            Pointer to cache, NULL if cache slot exhausted or object too large
+ */
+struct SlabCache* slab_cache_create(const char *name, uint32_t object_size, uint32_t align, void (*constructor)(void *object));
+
+/**
+ * Allocate object from cache, object is in constructed state
+ *
+ * @param cache Cache returned by slab_cache_create()
+ * @return      Pointer to object, NULL if out of memory
+ */
+void* slab_cache_alloc(struct SlabCache *cache);
+
+/**
+ * Return object into its cache, object should be in constructed state
+ *
+ * @param cache  Cache used for allocation
+ * @param object Object to free
+ */
+void slab_cache_free(struct SlabCache *cache, void *object);
+
+/**
+ * Allocate kernel memory from size class cache, or from frame allocator if larger than SLAB_SIZE_CLASS_MAX
+ *
+ * @param size Byte count
+ * @return     Pointer to memory aligned at least SLAB_OBJECT_ALIGN_MIN, NULL if out of memory
+ */
+void* kmalloc(uint32_t size);
+
+/**
+ * Free memory returned by kmalloc()
+ *
+ * @param ptr Pointer returned by kmalloc(), NULL is ignored
+ */
+void kfree(void *ptr);
+
+// Get copy of kernel heap counters - @return SlabStatistic
+struct SlabStatistic slab_get_statistic(void);
+
+#endif
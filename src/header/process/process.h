@@ -6,16 +6,24 @@
 #include <stddef.h>
 
 #include "header/cpu/interrupt.h"
+#include "header/cpu/fpu.h"
 #include "header/memory/paging.h"
 #include "header/filesystem/fat32.h"
 
 #define PROCESS_NAME_LENGTH_MAX          32
-#define PROCESS_PAGE_FRAME_COUNT_MAX     8
-#define PROCESS_COUNT_MAX                16
+// Resident page frame limit per process, in PAGE_FRAME_SIZE unit
+#define PROCESS_PAGE_FRAME_COUNT_MAX     8192
+// Process table start with this many slot and doubled when full
+#define PROCESS_LIST_INITIAL_CAPACITY    16
+#define PROCESS_PID_HASH_BUCKET_COUNT    1024
 
 #define KERNEL_RESERVED_PAGE_FRAME_COUNT 4
 #define KERNEL_VIRTUAL_ADDRESS_BASE      0xC0000000
 
+// User stack region right below kernel, page frame is allocated as stack grow
+#define PROCESS_USER_STACK_SIZE          (4 * 1024 * 1024)
+#define PROCESS_USER_STACK_BASE          (KERNEL_VIRTUAL_ADDRESS_BASE - PROCESS_USER_STACK_SIZE)
+
 #define CPU_EFLAGS_BASE_FLAG               0x2
 #define CPU_EFLAGS_FLAG_CARRY              0x1
 #define CPU_EFLAGS_FLAG_PARITY             0x4
@@ -48,14 +56,28 @@
 
 /**
  * Process state for PCB. 
- * It's guaranteed *at most* 1 running process exist at any time
+ * It's guaranteed *at most* 1 running process exist at any time.
+ * Waiting process is runnable & queued in run queue, blocked process is queued in wait queue until woken
  */
 typedef enum PROCESS_STATE {
     PROCESS_STOPPED = 0,
     PROCESS_RUNNING = 1,
     PROCESS_WAITING = 2,
+    PROCESS_BLOCKED = 3,
 } PROCESS_STATE;
 
+/**
+ * Doubly linked queue of process, threaded through PCB scheduler.queue_next & queue_prev.
+ * Used as scheduler run queue and as wait queue, process is in at most one queue
+ * 
+ * @param head First process, NULL if empty
+ * @param tail Last process
+ */
+struct ProcessQueue {
+    struct ProcessControlBlock *head;
+    struct ProcessControlBlock *tail;
+};
+
 /**
  * Contain information needed for task to be able to get interrupted and resumed later
  * 
@@ -71,24 +93,61 @@ struct Context {
     struct PageDirectory *page_directory_virtual_addr;
 };
 
+/**
+ * Executable backing of process image, used for loading page on demand
+ * 
+ * @param parent_cluster Parent directory cluster of executable
+ * @param name           Executable name
+ * @param ext            Executable extension
+ * @param base           Load address, start of image range
+ * @param size           Image range size (request buffer_size), area beyond file content is zero-filled
+ * @param filesize       Executable file size in bytes
+ * @param first_cluster  First cluster of executable, image cache key
+ */
+struct ProcessImage {
+    uint32_t parent_cluster;
+    char     name[8];
+    char     ext[3];
+    void     *base;
+    uint32_t size;
+    uint32_t filesize;
+    uint32_t first_cluster;
+};
+
 /**
  * Structure data containing information about a process
  * 
- * @param metadata Process metadata, contain various information about process
- * @param context  Process context used for context saving & switching
- * @param memory   Memory used for the process
+ * @param metadata  Process metadata, contain various information about process
+ * @param context   Process context used for context saving & switching
+ * @param memory    Memory used for the process, page_frame_used_count is resident page frame count
+ * @param image     Executable backing for demand paging
+ * @param fpu_state FXSAVE area, allocated on first FPU use. Live state is in FPU register while process own FPU
+ * @param scheduler Multilevel feedback queue state, nice is base priority. Queue link is valid while waiting or blocked,
+ *                  wait_queue & wake_tick is valid while blocked. exit_wait_queue hold process waiting for this one to exit
  */
 struct ProcessControlBlock {
     struct {
-        uint32_t      pid;
-        char          name[PROCESS_NAME_LENGTH_MAX];
-        PROCESS_STATE state;
+        uint32_t                   pid;
+        char                       name[PROCESS_NAME_LENGTH_MAX];
+        PROCESS_STATE              state;
+        struct ProcessControlBlock *pid_next;
     } metadata;
     struct Context context;
     struct {
-        void     *virtual_addr_used[PROCESS_PAGE_FRAME_COUNT_MAX];
         uint32_t page_frame_used_count;
     } memory;
+    struct ProcessImage image;
+    struct FPUState     *fpu_state;
+    struct {
+        uint8_t                    priority;
+        uint8_t                    nice;
+        uint32_t                   tick_left;
+        struct ProcessControlBlock *queue_next;
+        struct ProcessControlBlock *queue_prev;
+        struct ProcessQueue        *wait_queue;
+        uint32_t                   wake_tick;
+        struct ProcessQueue        exit_wait_queue;
+    } scheduler;
 };
 
 
@@ -96,34 +155,79 @@ struct ProcessControlBlock {
 
 
 /**
- * All system process control block available to use
+ * Process table, _process_list[0 ... _process_list_capacity-1] is either NULL or PCB allocated from slab cache.
+ * Table is allocated with kmalloc() and grow at runtime. Used for enumeration only,
+ * lookup is done through PID hash & scheduler running pointer
  */
-extern struct ProcessControlBlock _process_list[PROCESS_COUNT_MAX];
+extern struct ProcessControlBlock **_process_list;
+extern uint32_t                   _process_list_capacity;
 
 
 
 
 
 /**
- * Get currently running process PCB pointer
+ * Get currently running process PCB pointer, maintained by scheduler in O(1)
  * 
  * @return Will return NULL if there's no running process
  */
 struct ProcessControlBlock* process_get_current_running_pcb_pointer(void);
 
+/**
+ * Find process that is not stopped through PID hash
+ * 
+ * @param pid Process ID
+ * @return    PCB pointer, NULL if not found
+ */
+struct ProcessControlBlock* process_get_pcb_by_pid(uint32_t pid);
+
 /**
  * Create new user process and setup the virtual address space.
+ * Executable is not read here, image & stack range is left not-present and loaded by process_handle_page_fault().
  * All available return code is defined with macro "PROCESS_CREATE_*"
  * 
  * @note          This procedure assumes no reentrancy in ISR
- * @warning       Assuming read(request) always success and request.buf point to load address
+ * @warning       Assuming request.buf point to load address
  * @param request Appropriate read request for the executable
  * @return        Process creation return code
  */
 int32_t process_create_user_process(struct FAT32DriverRequest request);
 
 /**
- * Destroy process then release page directory and process control block
+ * Map page of running process that contain fault_addr. Page inside image range is mapped from
+ * image cache or read from its executable, page inside user stack region is zero-filled.
+ * Write into present copy-on-write page get private copy
+ * 
+ * @param fault_addr Faulting virtual address (CR2)
+ * @param error_code Page fault error code, combination of PAGE_FAULT_ERROR_*
+ * @return           True if page is loaded and faulting instruction can be restarted
+ */
+bool process_handle_page_fault(void *fault_addr, uint32_t error_code);
+
+/**
+ * Map every not-present page in user buffer of running process, and break copy-on-write of destination buffer.
+ * Must be called before file system access user buffer, as page fault in the middle of file system
+ * operation would reenter file system, and disk DMA into shared frame would bypass copy-on-write
+ * 
+ * @param addr  User buffer address
+ * @param size  User buffer size in bytes
+ * @param write Buffer is written by kernel, every page must end up private & writable
+ * @return      False if buffer is outside image & stack range, reach kernel address, or cannot be made writable
+ */
+bool process_prefault_user_range(const void *addr, uint32_t size, bool write);
+
+/**
+ * Duplicate running process. Address space is shared copy-on-write, and child start
+ * from context with eax = 0. Open file handle is not inherited
+ * 
+ * @param context Running process context at fork syscall, child resume from here
+ * @return        Child PID, -1 if process table or page directory cannot be allocated
+ */
+int32_t process_fork(struct Context context);
+
+/**
+ * Destroy process, release every user page frame, page table & page directory then return PCB into free list.
+ * Process waiting for its exit is woken up. Caller must switch into next process if running process is destroyed
  * 
  * @param pid Process ID to delete
  * @return    True if process destruction success
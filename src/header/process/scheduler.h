@@ -3,6 +3,23 @@
 
 #include "header/process/process.h"
 
+/* -- Scheduler constants -- */
+// Multilevel feedback queue, priority 0 is highest
+#define SCHEDULER_PRIORITY_COUNT    4
+// Quantum of priority p is SCHEDULER_QUANTUM_BASE_TICK << p timer tick
+#define SCHEDULER_QUANTUM_BASE_TICK 5
+// Every process is moved back into its base priority after this many timer tick
+#define SCHEDULER_BOOST_INTERVAL    1000
+// scheduler_next_event_tick() return value if no timer interrupt is needed
+#define SCHEDULER_NO_EVENT          0xFFFFFFFF
+
+// Return code constant for scheduler_set_nice()
+#define SCHEDULER_SET_NICE_SUCCESS         0
+#define SCHEDULER_SET_NICE_FAIL_NOT_FOUND  1
+#define SCHEDULER_SET_NICE_FAIL_INVALID    2
+
+
+
 /**
  * Read all general purpose register values and set control register.
  * Resume the execution flow back to ctx.eip and ctx.eflags
@@ -20,6 +37,13 @@ __attribute__((noreturn)) extern void process_context_switch(struct Context ctx)
  */
 void scheduler_init(void); 
 
+/**
+ * Get process currently running on CPU without scanning process table
+ * 
+ * @return Running process, NULL if CPU is idle or running process is blocked / destroyed
+ */
+struct ProcessControlBlock* scheduler_get_running_process(void);
+
 /**
  * Save context to current running process
  * 
@@ -28,8 +52,96 @@ void scheduler_init(void);
 void scheduler_save_context_to_current_running_pcb(struct Context ctx);
 
 /**
- * Trigger the scheduler algorithm and context switch to new process
+ * Make new process runnable at its base priority (nice) with full quantum, tickless timer is re-armed
+ * 
+ * @param pcb Process that is not running nor queued
+ */
+void scheduler_add_process(struct ProcessControlBlock *pcb);
+
+/**
+ * Remove waiting process from run queue or blocked process from its wait queue, running process is left untouched
+ * 
+ * @param pcb Process to remove
+ */
+void scheduler_remove_process(struct ProcessControlBlock *pcb);
+
+/**
+ * Advance scheduler clock, wake sleeping process that is due and boost every process periodically.
+ * Called for every timer interrupt including interrupt from kernel & idle loop, and on tickless context switch
+ * 
+ * @param tick Elapsed timer tick
+ */
+void scheduler_clock_tick(uint32_t tick);
+
+/**
+ * Account timer tick for running process, only called when interrupted from user mode.
+ * Process that use whole quantum is demoted
+ * 
+ * @param tick Elapsed timer tick, 0 only check for higher priority process
+ * @return     True if running process should be preempted, either quantum expired or higher priority process is waiting
+ */
+bool scheduler_tick(uint32_t tick);
+
+/**
+ * Timer tick until scheduler need next timer interrupt: sleeping process wake up, quantum expiry or priority boost.
+ * Quantum & boost is ignored while no other process is waiting for CPU
+ * 
+ * @return 0 if already due, SCHEDULER_NO_EVENT if nothing is pending
+ */
+uint32_t scheduler_next_event_tick(void);
+
+// Get scheduler clock, timer tick since boot
+uint32_t scheduler_get_clock_tick(void);
+
+/**
+ * Give up CPU without demotion, remaining quantum is kept for next turn
+ * 
+ * @param ctx Context of running process to resume later
+ */
+__attribute__((noreturn)) void scheduler_yield(struct Context ctx);
+
+/**
+ * Block running process in wait queue until scheduler_wake_up(), then switch into next process.
+ * Process resume from ctx, syscall that need to be retried should rewind ctx.eip
+ * 
+ * @param queue Wait queue
+ * @param ctx   Context of running process to resume later
+ */
+__attribute__((noreturn)) void scheduler_block_current_process(struct ProcessQueue *queue, struct Context ctx);
+
+/**
+ * Block running process for at least tick timer tick
+ * 
+ * @param tick Timer tick count
+ * @param ctx  Context of running process to resume later
+ */
+__attribute__((noreturn)) void scheduler_sleep_current_process(uint32_t tick, struct Context ctx);
+
+/**
+ * Make every process blocked in wait queue runnable, tickless timer is re-armed. Safe to call from interrupt handler
+ * 
+ * @param queue Wait queue
+ */
+void scheduler_wake_up(struct ProcessQueue *queue);
+
+/**
+ * Move running process into its base priority with full quantum, used when interactive process receive input
+ */
+void scheduler_boost_current_process(void);
+
+/**
+ * Set base priority of process, lower nice mean higher priority
+ * 
+ * @param pid  Process ID
+ * @param nice Base priority, 0 ... SCHEDULER_PRIORITY_COUNT-1
+ * @return     SCHEDULER_SET_NICE_* return code
+ */
+int8_t scheduler_set_nice(uint32_t pid, uint8_t nice);
+
+/**
+ * Trigger the scheduler algorithm and context switch to new process.
+ * Running process is queued back at tail of its priority, CPU is halted while nothing is runnable
  */
 __attribute__((noreturn)) void scheduler_switch_to_next_process(void);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,49 @@
+#ifndef _STRING_BENCHMARK_H
+#define _STRING_BENCHMARK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* -- String benchmark constants -- */
+// Function: memcpy, memset, memcmp, memmove (overlapping by all but 4 bytes, backward)
+#define STRING_BENCHMARK_FUNCTION_COUNT 4
+// Size: 8, 64, 512, 4096, 32768 bytes
+#define STRING_BENCHMARK_SIZE_COUNT     5
+#define STRING_BENCHMARK_SIZE_MIN       8
+#define STRING_BENCHMARK_SIZE_SHIFT     3
+#define STRING_BENCHMARK_SIZE_MAX       (STRING_BENCHMARK_SIZE_MIN << (STRING_BENCHMARK_SIZE_SHIFT * (STRING_BENCHMARK_SIZE_COUNT - 1)))
+// Alignment: both aligned, both offset by 1, destination offset by 3 from aligned source
+#define STRING_BENCHMARK_ALIGN_COUNT    3
+// Variant: rep string, SSE2 if available
+#define STRING_BENCHMARK_VARIANT_COUNT  2
+// Every cell process this many bytes, bytes per cycle is STRING_BENCHMARK_CELL_BYTES / cycle
+#define STRING_BENCHMARK_CELL_BYTES     (1u << 20)
+// Two non-overlapping area of SIZE_MAX plus alignment slack
+#define STRING_BENCHMARK_BUFFER_SIZE    (2*STRING_BENCHMARK_SIZE_MAX + 64)
+
+
+
+/**
+ * Cycle count of every benchmark cell
+ *
+ * @param variant_count Measured variant, variant 1 is SSE2 and only measured if SSE2 path is registered
+ * @param cycle         rdtsc cycle to process STRING_BENCHMARK_CELL_BYTES, indexed by variant, function, size, alignment
+ */
+struct StringBenchmarkResult {
+    uint32_t variant_count;
+    uint32_t cycle[STRING_BENCHMARK_VARIANT_COUNT][STRING_BENCHMARK_FUNCTION_COUNT][STRING_BENCHMARK_SIZE_COUNT][STRING_BENCHMARK_ALIGN_COUNT];
+};
+
+
+
+/**
+ * Measure memcpy(), memset(), memcmp() & memmove() by size and alignment, with and without SSE2.
+ * SSE2 path is left enabled afterward if it is registered
+ *
+ * @param buffer Scratch memory of STRING_BENCHMARK_BUFFER_SIZE bytes
+ * @param result Benchmark result
+ */
+void string_benchmark_run(uint8_t *buffer, struct StringBenchmarkResult *result);
+
+#endif
@@ -2,8 +2,14 @@
 #define _STRING_H
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+// memcpy() & memset() below this size is done bytewise, alignment setup cost more than it save
+#define STRING_WORD_THRESHOLD 16
+// memcpy() between mutually misaligned buffer from this size use SSE2 if enabled, covering FPU register save & restore
+#define STRING_SSE2_THRESHOLD 2048
+
 /**
  * C standard memset, check man memset or
  * https://man7.org/linux/man-pages/man3/memset.3.html for more details
@@ -52,4 +58,21 @@ int memcmp(const void *s1, const void *s2, size_t n);
 */
 void *memmove(void *dest, const void *src, size_t n);
 
-#endif
\ No newline at end of file
+/**
+ * Register SSE2 path for large misaligned memcpy() and enable it. Caller must check CPU support
+ * 
+ * @param fpu_begin Called before SSE2 register is used, NULL if FPU register is always usable
+ * @param fpu_end   Called after SSE2 register is used, NULL if FPU register is always usable
+*/
+void string_enable_sse2(void (*fpu_begin)(void), void (*fpu_end)(void));
+
+/**
+ * Toggle registered SSE2 path, for benchmark
+ * 
+ * @param enable Use SSE2 path
+ * 
+ * @return False if enabling SSE2 path that is never registered
+*/
+bool string_set_sse2(bool enable);
+
+#endif
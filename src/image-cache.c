@@ -0,0 +1,104 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/filesystem/image-cache.h"
+#include "header/memory/frame-allocator.h"
+#include "header/memory/slab.h"
+
+/**
+ * Image cache states
+ *
+ * @param bucket    Hash bucket, singly linked list of entry allocated with kmalloc()
+ * @param statistic Cache counters
+ */
+static struct {
+    struct ImageCacheEntry     *bucket[IMAGE_CACHE_HASH_BUCKET_COUNT];
+    struct ImageCacheStatistic statistic;
+} image_cache_state = {0};
+
+
+
+// -- Internal helper --
+static struct ImageCacheEntry** image_cache_bucket(uint32_t first_cluster, uint32_t page_offset) {
+    uint32_t hash = first_cluster * 31 + page_offset / PAGE_FRAME_SIZE;
+    return &image_cache_state.bucket[hash % IMAGE_CACHE_HASH_BUCKET_COUNT];
+}
+
+// Unlink entry pointed by link, release its frame reference
+static void image_cache_remove(struct ImageCacheEntry **link) {
+    struct ImageCacheEntry *entry = *link;
+    *link = entry->next;
+    frame_free(entry->physical_addr, 0);
+    kfree(entry);
+    image_cache_state.statistic.entry_count--;
+}
+
+
+
+// -- Public interfaces --
+uint32_t image_cache_lookup(uint32_t first_cluster, uint32_t page_offset) {
+    struct ImageCacheEntry *entry = *image_cache_bucket(first_cluster, page_offset);
+    while (entry != NULL && (entry->first_cluster != first_cluster || entry->page_offset != page_offset))
+        entry = entry->next;
+    if (entry == NULL) {
+        image_cache_state.statistic.miss++;
+        return IMAGE_CACHE_MISS;
+    }
+    image_cache_state.statistic.hit++;
+    frame_reference_add(entry->physical_addr);
+    return entry->physical_addr;
+}
+
+void image_cache_insert(uint32_t first_cluster, uint32_t page_offset, uint32_t physical_addr) {
+    // Failing to cache only cost another file read on next launch
+    struct ImageCacheEntry *entry = kmalloc(sizeof(struct ImageCacheEntry));
+    if (entry == NULL)
+        return;
+    struct ImageCacheEntry **bucket = image_cache_bucket(first_cluster, page_offset);
+    *entry = (struct ImageCacheEntry) {
+        .first_cluster = first_cluster,
+        .page_offset   = page_offset,
+        .physical_addr = physical_addr,
+        .next          = *bucket,
+    };
+    *bucket = entry;
+    frame_reference_add(physical_addr);
+    image_cache_state.statistic.entry_count++;
+}
+
+void image_cache_invalidate(uint32_t first_cluster) {
+    if (image_cache_state.statistic.entry_count == 0)
+        return;
+    for (uint32_t i = 0; i < IMAGE_CACHE_HASH_BUCKET_COUNT; i++) {
+        struct ImageCacheEntry **link = &image_cache_state.bucket[i];
+        while (*link != NULL) {
+            if ((*link)->first_cluster == first_cluster) {
+                image_cache_remove(link);
+                image_cache_state.statistic.invalidation++;
+            } else {
+                link = &(*link)->next;
+            }
+        }
+    }
+}
+
+uint32_t image_cache_shrink(void) {
+    uint32_t released = 0;
+    for (uint32_t i = 0; i < IMAGE_CACHE_HASH_BUCKET_COUNT; i++) {
+        struct ImageCacheEntry **link = &image_cache_state.bucket[i];
+        while (*link != NULL) {
+            if (frame_reference_count((*link)->physical_addr) == 1) {
+                image_cache_remove(link);
+                image_cache_state.statistic.shrink++;
+                released++;
+            } else {
+                link = &(*link)->next;
+            }
+        }
+    }
+    return released;
+}
+
+struct ImageCacheStatistic image_cache_get_statistic(void) {
+    return image_cache_state.statistic;
+}
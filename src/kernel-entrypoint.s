@@ -8,8 +8,8 @@ extern _paging_kernel_page_directory ; kernel page directory
 KERNEL_VIRTUAL_BASE equ 0xC0000000    ; kernel virtual memory
 KERNEL_STACK_SIZE   equ 2097152       ; size of stack in bytes
 MAGIC_NUMBER        equ 0x1BADB002    ; define the magic number constant
-FLAGS               equ 0x0           ; multiboot flags
-CHECKSUM            equ -MAGIC_NUMBER ; calculate the checksum (magic number + checksum + flags == 0)
+FLAGS               equ 0x2           ; multiboot flags, request memory information
+CHECKSUM            equ -(MAGIC_NUMBER + FLAGS) ; calculate the checksum (magic number + checksum + flags == 0)
 
 
 section .bss
@@ -29,6 +29,9 @@ align 4             ; the code must be 4 byte aligned
 section .setup.text 
 loader equ (loader_entrypoint - KERNEL_VIRTUAL_BASE)
 loader_entrypoint:         ; the loader label (defined as entry point in linker script)
+    ; Bootloader magic number in eax & multiboot information physical address in ebx
+    mov ecx, eax
+
     ; Set CR3 (CPU page register)
     mov eax, _paging_kernel_page_directory - KERNEL_VIRTUAL_BASE
     mov cr3, eax
@@ -51,6 +54,8 @@ loader_virtual:
     mov dword [_paging_kernel_page_directory], 0
     invlpg [0]                                ; Delete identity mapping and invalidate TLB cache for first page
     mov esp, kernel_stack + KERNEL_STACK_SIZE ; Setup stack register to proper location
+    push ebx                                  ; kernel_setup(multiboot_magic, multiboot_info_phys_addr)
+    push ecx
     call kernel_setup
 .loop:
     jmp .loop                                 ; loop forever
@@ -3,21 +3,34 @@
 #include "header/cpu/gdt.h"
 #include "header/cpu/idt.h"
 #include "header/cpu/interrupt.h"
+#include "header/cpu/fpu.h"
+#include "header/cpu/apic.h"
+#include "header/cpu/clocksource.h"
 #include "header/kernel-entrypoint.h"
 #include "header/driver/keyboard.h"
+#include "header/driver/disk.h"
+#include "header/driver/cmos.h"
 #include "header/text/framebuffer.h"
 #include "header/filesystem/fat32.h"
 #include "header/memory/paging.h"
+#include "header/memory/frame-allocator.h"
 #include "header/process/process.h"
 #include "header/process/scheduler.h"
 
-void kernel_setup(void) {
+void kernel_setup(uint32_t multiboot_magic, uint32_t multiboot_info_phys_addr) {
     load_gdt(&_gdt_gdtr);
+    paging_initialize();
+    frame_allocator_initialize(multiboot_magic, multiboot_info_phys_addr);
+    fpu_initialize();
+    apic_initialize();
     pic_remap();
     initialize_idt();
     activate_keyboard_interrupt();
     framebuffer_clear();
     framebuffer_set_cursor(0, 0);
+    disk_initialize();
+    cmos_initialize();
+    clocksource_initialize();
     initialize_filesystem_fat32();
     gdt_install_tss();
     set_tss_register();
@@ -31,8 +44,9 @@ void kernel_setup(void) {
         .buffer_size           = 0x100000,
     };
 
-    // Set TSS.esp0 for interprivilege interrupt
+    // Set TSS.esp0 for interprivilege interrupt, shared with sysenter
     set_tss_kernel_current_stack();
+    activate_sysenter_syscall();
 
     // Create new user process and give the flow the user program
     process_create_user_process(request);
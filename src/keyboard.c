@@ -1,6 +1,9 @@
 #include "header/driver/keyboard.h"
 #include "header/cpu/portio.h"
 #include "header/stdlib/string.h"
+#include "header/process/scheduler.h"
+
+struct ProcessQueue _keyboard_wait_queue = {0};
 
 /** 
  * Contain all driver states
@@ -60,7 +63,10 @@ void get_keyboard_buffer(char *buf) {
 
 void keyboard_isr(void) {
     uint8_t scancode = in(KEYBOARD_DATA_PORT);
-    if (keyboard_driver_state.listen_input) 
+    if (keyboard_driver_state.listen_input) {
         keyboard_driver_state.buffer = keyboard_scancode_1_to_ascii_map[scancode];
+        if (keyboard_driver_state.buffer != 0)
+            scheduler_wake_up(&_keyboard_wait_queue);
+    }
     pic_ack(IRQ_KEYBOARD);
 }
@@ -2,6 +2,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include "header/memory/paging.h"
+#include "header/memory/frame-allocator.h"
+#include "header/stdlib/string.h"
 
 __attribute__((aligned(0x1000))) struct PageDirectory _paging_kernel_page_directory = {
     .table = {
@@ -20,14 +22,6 @@ __attribute__((aligned(0x1000))) struct PageDirectory _paging_kernel_page_direct
     }
 };
 
-static struct PageManagerState page_manager_state = {
-    .page_frame_map        = {
-        [0]                            = true,
-        [1 ... PAGE_FRAME_MAX_COUNT-1] = false
-    },
-    .free_page_frame_count = PAGE_FRAME_MAX_COUNT,
-};
-
 void update_page_directory_entry(
     struct PageDirectory *page_dir,
     void *physical_addr, 
@@ -47,92 +41,219 @@ void flush_single_tlb(void *virtual_addr) {
 
 
 /* --- Memory Management --- */
+void paging_initialize(void) {
+    struct PageDirectoryEntryFlag flag = {
+        .present_bit       = 1,
+        .write_bit         = 1,
+        .use_pagesize_4_mb = 1,
+    };
+    for (uint32_t physical_addr = PAGE_LARGE_SIZE; physical_addr < (FRAME_MEMORY_MAX_MB << 20); physical_addr += PAGE_LARGE_SIZE)
+        update_page_directory_entry(
+            &_paging_kernel_page_directory,
+            (void*) physical_addr,
+            PAGING_DIRECT_MAP(physical_addr),
+            flag
+        );
+
+    // CR0.WP (bit 16), supervisor write respect read-only page
+    uint32_t cr0;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0): /* <Empty> */);
+    __asm__ volatile("mov %0, %%cr0" : /* <Empty> */ : "r"(cr0 | (1 << 16)): "memory");
+}
+
+void* paging_map_kernel_mmio(uint32_t physical_addr) {
+    uint32_t region_addr = physical_addr & ~(PAGE_LARGE_SIZE - 1);
+    if (region_addr < (uint32_t) PAGING_DIRECT_MAP(FRAME_MEMORY_MAX_MB << 20))
+        return NULL;
+
+    struct PageDirectoryEntryFlag flag = {
+        .present_bit       = 1,
+        .write_bit         = 1,
+        .disable_caching   = 1,
+        .use_pagesize_4_mb = 1,
+    };
+    update_page_directory_entry(&_paging_kernel_page_directory, (void*) region_addr, (void*) region_addr, flag);
+    return (void*) physical_addr;
+}
+
 bool paging_allocate_check(uint32_t amount) {
-    return page_manager_state.free_page_frame_count >= amount;
+    return frame_allocate_check(amount);
 }
 
+// Allocate single zeroed page frame, return physical address or 0 if out of memory
+static uint32_t paging_allocate_frame(void) {
+    uint32_t physical_addr = frame_allocate(0);
+    if (physical_addr != FRAME_ALLOCATE_FAIL)
+        memset(PAGING_DIRECT_MAP(physical_addr), 0, PAGE_FRAME_SIZE);
+    return physical_addr;
+}
+
+static void paging_free_frame(uint32_t physical_addr) {
+    frame_free(physical_addr, 0);
+}
+
+/**
+ * Get page table entry that map virtual address
+ * 
+ * @param create Allocate page table if directory entry is not present
+ * @return       NULL if page table not exist (or cannot be created) or address is mapped by 4 MiB page
+ */
+static struct PageTableEntry* paging_get_page_table_entry(struct PageDirectory *page_dir, void *virtual_addr, bool create) {
+    struct PageDirectoryEntry *dir_entry = &page_dir->table[((uint32_t) virtual_addr >> 22) & 0x3FF];
+    if (dir_entry->flag.use_pagesize_4_mb)
+        return NULL;
+    if (!dir_entry->flag.present_bit) {
+        uint32_t table_physical_addr;
+        if (!create || (table_physical_addr = paging_allocate_frame()) == 0)
+            return NULL;
+        // Access right is checked on both level, restriction is left to page table entry
+        dir_entry->flag.present_bit = 1;
+        dir_entry->flag.write_bit   = 1;
+        dir_entry->flag.user_bit    = 1;
+        dir_entry->table_address    = table_physical_addr >> 12;
+    }
+    struct PageTable *page_table = PAGING_DIRECT_MAP(dir_entry->table_address << 12);
+    return &page_table->table[((uint32_t) virtual_addr >> 12) & 0x3FF];
+}
 
 bool paging_allocate_user_page_frame(struct PageDirectory *page_dir, void *virtual_addr) {
-    if (!paging_allocate_check(1))
+    struct PageTableEntry *entry = paging_get_page_table_entry(page_dir, virtual_addr, true);
+    if (entry == NULL || entry->present_bit)
         return false;
-    
-    for (int i = 0; i < PAGE_FRAME_MAX_COUNT; ++i) {
-        if (!page_manager_state.page_frame_map[i]) {
-            page_manager_state.page_frame_map[i] = true;
-            page_manager_state.free_page_frame_count--;
-            struct PageDirectoryEntryFlag flag = {
-                .present_bit       = true,
-                .write_bit         = true,
-                .user_bit          = true,
-                .use_pagesize_4_mb = true,
-            };
-            update_page_directory_entry(
-                page_dir,
-                (void*) (i * PAGE_FRAME_SIZE),
-                virtual_addr,
-                flag
-            );
-            return true;
-        }
-    }
 
-    return false;
+    uint32_t physical_addr = paging_allocate_frame();
+    if (physical_addr == 0)
+        return false;
+    *entry = (struct PageTableEntry) {
+        .present_bit   = true,
+        .write_bit     = true,
+        .user_bit      = true,
+        .frame_address = physical_addr >> 12,
+    };
+    flush_single_tlb(virtual_addr);
+    return true;
+}
+
+bool paging_map_shared_user_page_frame(struct PageDirectory *page_dir, void *virtual_addr, uint32_t physical_addr) {
+    struct PageTableEntry *entry = paging_get_page_table_entry(page_dir, virtual_addr, true);
+    if (entry == NULL || entry->present_bit)
+        return false;
+
+    frame_reference_add(physical_addr);
+    *entry = (struct PageTableEntry) {
+        .present_bit   = true,
+        .user_bit      = true,
+        .copy_on_write = true,
+        .frame_address = physical_addr >> 12,
+    };
+    flush_single_tlb(virtual_addr);
+    return true;
 }
 
 bool paging_free_user_page_frame(struct PageDirectory *page_dir, void *virtual_addr) {
-    uint32_t                  page_index = (uint32_t) virtual_addr >> 22;
-    struct PageDirectoryEntry entry      = page_dir->table[page_index];
-    if (!entry.flag.present_bit)
+    struct PageTableEntry *entry = paging_get_page_table_entry(page_dir, virtual_addr, false);
+    if (entry == NULL || !entry->present_bit)
         return false;
-    page_manager_state.page_frame_map[entry.lower_address] = false;
-    page_manager_state.free_page_frame_count++;
-
-    struct PageDirectoryEntryFlag flag = {0};
-    update_page_directory_entry(
-        page_dir,
-        (void*) 0,
-        virtual_addr,
-        flag
-    );
+
+    paging_free_frame(entry->frame_address << 12);
+    *entry = (struct PageTableEntry) {0};
+    flush_single_tlb(virtual_addr);
     return true;
 }
 
 #include "header/kernel-entrypoint.h"
-#include "header/stdlib/string.h"
-
-__attribute__((aligned(0x1000))) static struct PageDirectory page_directory_list[PAGING_DIRECTORY_TABLE_MAX_COUNT] = {0};
-static struct {
-    bool page_directory_used[PAGING_DIRECTORY_TABLE_MAX_COUNT];
-} page_directory_manager = {
-    .page_directory_used = {false},
-};
 
+// Page directory is single page frame taken from frame allocator, accessed through direct map
 struct PageDirectory* paging_create_new_page_directory(void) {
-    for (uint32_t i = 0; i < PAGING_DIRECTORY_TABLE_MAX_COUNT; ++i) {
-        if (!page_directory_manager.page_directory_used[i]) {
-            page_directory_manager.page_directory_used[i] = true;
-            struct PageDirectoryEntry kernel_entry = {
-                .flag.present_bit       = 1,
-                .flag.write_bit         = 1,
-                .flag.use_pagesize_4_mb = 1,
-                .lower_address          = 0,
-            };
-            page_directory_list[i].table[0x300] = kernel_entry;
-            return &page_directory_list[i];
-        }
-    }
-    return NULL;
+    uint32_t physical_addr = paging_allocate_frame();
+    if (physical_addr == FRAME_ALLOCATE_FAIL)
+        return NULL;
+
+    struct PageDirectory *page_dir = PAGING_DIRECT_MAP(physical_addr);
+    memcpy(
+        &page_dir->table[PAGING_KERNEL_DIRECTORY_INDEX],
+        &_paging_kernel_page_directory.table[PAGING_KERNEL_DIRECTORY_INDEX],
+        (PAGE_ENTRY_COUNT - PAGING_KERNEL_DIRECTORY_INDEX) * sizeof(struct PageDirectoryEntry)
+    );
+    return page_dir;
 }
 
 bool paging_free_page_directory(struct PageDirectory *page_dir) {
-    for (uint32_t i = 0; i < PAGING_DIRECTORY_TABLE_MAX_COUNT; ++i) {
-        if (&page_directory_list[i] == page_dir) {
-            page_directory_manager.page_directory_used[i] = false;
-            memset(page_dir, 0, sizeof(struct PageDirectory));
-            return true;
+    if (page_dir == NULL || page_dir == &_paging_kernel_page_directory)
+        return false;
+
+    // Release user half, kernel half is shared with every page directory
+    for (uint32_t dir_index = 0; dir_index < PAGING_KERNEL_DIRECTORY_INDEX; ++dir_index) {
+        struct PageDirectoryEntry dir_entry = page_dir->table[dir_index];
+        if (!dir_entry.flag.present_bit || dir_entry.flag.use_pagesize_4_mb)
+            continue;
+        struct PageTable *page_table = PAGING_DIRECT_MAP(dir_entry.table_address << 12);
+        for (uint32_t table_index = 0; table_index < PAGE_ENTRY_COUNT; ++table_index)
+            if (page_table->table[table_index].present_bit)
+                paging_free_frame(page_table->table[table_index].frame_address << 12);
+        paging_free_frame(dir_entry.table_address << 12);
+    }
+    paging_free_frame(PAGING_DIRECT_MAP_TO_PHYSICAL(page_dir));
+    return true;
+}
+
+struct PageDirectory* paging_fork_page_directory(struct PageDirectory *page_dir) {
+    struct PageDirectory *new_page_dir = paging_create_new_page_directory();
+    if (new_page_dir == NULL)
+        return NULL;
+
+    for (uint32_t dir_index = 0; dir_index < PAGING_KERNEL_DIRECTORY_INDEX; ++dir_index) {
+        struct PageDirectoryEntry dir_entry = page_dir->table[dir_index];
+        if (!dir_entry.flag.present_bit || dir_entry.flag.use_pagesize_4_mb)
+            continue;
+        uint32_t table_physical_addr = paging_allocate_frame();
+        if (table_physical_addr == FRAME_ALLOCATE_FAIL) {
+            // Pages already marked in parent stay copy-on-write, resolved in place when written
+            paging_free_page_directory(new_page_dir);
+            return NULL;
+        }
+
+        struct PageTable *page_table     = PAGING_DIRECT_MAP(dir_entry.table_address << 12);
+        struct PageTable *new_page_table = PAGING_DIRECT_MAP(table_physical_addr);
+        for (uint32_t table_index = 0; table_index < PAGE_ENTRY_COUNT; ++table_index) {
+            struct PageTableEntry *entry = &page_table->table[table_index];
+            if (!entry->present_bit)
+                continue;
+            if (entry->write_bit) {
+                entry->write_bit     = 0;
+                entry->copy_on_write = 1;
+            }
+            new_page_table->table[table_index] = *entry;
+            frame_reference_add(entry->frame_address << 12);
         }
+        new_page_dir->table[dir_index]               = dir_entry;
+        new_page_dir->table[dir_index].table_address = table_physical_addr >> 12;
+    }
+
+    // Stale writable TLB entry of parent must be dropped
+    if (paging_get_current_page_directory_addr() == page_dir)
+        paging_use_page_directory(page_dir);
+    return new_page_dir;
+}
+
+bool paging_resolve_copy_on_write(struct PageDirectory *page_dir, void *virtual_addr) {
+    struct PageTableEntry *entry = paging_get_page_table_entry(page_dir, virtual_addr, false);
+    if (entry == NULL || !entry->present_bit || !entry->copy_on_write)
+        return false;
+
+    uint32_t physical_addr = entry->frame_address << 12;
+    if (frame_reference_count(physical_addr) > 1) {
+        uint32_t new_physical_addr = frame_allocate(0);
+        if (new_physical_addr == FRAME_ALLOCATE_FAIL)
+            return false;
+        memcpy(PAGING_DIRECT_MAP(new_physical_addr), PAGING_DIRECT_MAP(physical_addr), PAGE_FRAME_SIZE);
+        paging_free_frame(physical_addr);
+        entry->frame_address = new_physical_addr >> 12;
     }
-    return false;
+    entry->write_bit     = 1;
+    entry->copy_on_write = 0;
+    flush_single_tlb(virtual_addr);
+    return true;
 }
 
 struct PageDirectory* paging_get_current_page_directory_addr(void) {
@@ -142,6 +263,39 @@ struct PageDirectory* paging_get_current_page_directory_addr(void) {
     return (struct PageDirectory*) virtual_addr_page_dir;
 }
 
+void* paging_get_page_fault_addr(void) {
+    uint32_t fault_addr;
+    __asm__ volatile("mov %%cr2, %0" : "=r"(fault_addr): /* <Empty> */);
+    return (void*) fault_addr;
+}
+
+// Page walk, write access require writable entry on both level and no pending copy-on-write
+static bool paging_translate(struct PageDirectory *page_dir, void *virtual_addr, uint32_t *physical_addr, bool write) {
+    uint32_t                  page_index = ((uint32_t) virtual_addr >> 22) & 0x3FF;
+    struct PageDirectoryEntry entry      = page_dir->table[page_index];
+    if (!entry.flag.present_bit || (write && !entry.flag.write_bit))
+        return false;
+    if (entry.flag.use_pagesize_4_mb) {
+        *physical_addr = ((uint32_t) entry.lower_address << 22) | ((uint32_t) virtual_addr & (PAGE_LARGE_SIZE - 1));
+        return true;
+    }
+
+    struct PageTable      *page_table = PAGING_DIRECT_MAP(entry.table_address << 12);
+    struct PageTableEntry table_entry = page_table->table[((uint32_t) virtual_addr >> 12) & 0x3FF];
+    if (!table_entry.present_bit || (write && (!table_entry.write_bit || table_entry.copy_on_write)))
+        return false;
+    *physical_addr = ((uint32_t) table_entry.frame_address << 12) | ((uint32_t) virtual_addr & (PAGE_FRAME_SIZE - 1));
+    return true;
+}
+
+bool paging_virtual_to_physical_addr(struct PageDirectory *page_dir, void *virtual_addr, uint32_t *physical_addr) {
+    return paging_translate(page_dir, virtual_addr, physical_addr, false);
+}
+
+bool paging_virtual_to_writable_physical_addr(struct PageDirectory *page_dir, void *virtual_addr, uint32_t *physical_addr) {
+    return paging_translate(page_dir, virtual_addr, physical_addr, true);
+}
+
 void paging_use_page_directory(struct PageDirectory *page_dir_virtual_addr) {
     uint32_t physical_addr_page_dir = (uint32_t) page_dir_virtual_addr;
     // Additional layer of check & mistake safety net
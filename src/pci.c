@@ -0,0 +1,58 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "header/driver/pci.h"
+#include "header/cpu/portio.h"
+
+/**
+ * For additional information check OSDev
+ * Reference: https://wiki.osdev.org/PCI
+ */
+
+static uint32_t pci_config_address(struct PCIDeviceAddress addr, uint8_t offset) {
+    return PCI_CONFIG_ENABLE_BIT 
+        | ((uint32_t) addr.bus      << 16) 
+        | ((uint32_t) addr.device   << 11) 
+        | ((uint32_t) addr.function << 8) 
+        | (offset & 0xFC);
+}
+
+uint32_t pci_config_read(struct PCIDeviceAddress addr, uint8_t offset) {
+    out32(PCI_CONFIG_ADDRESS_PIO, pci_config_address(addr, offset));
+    return in32(PCI_CONFIG_DATA_PIO);
+}
+
+void pci_config_write(struct PCIDeviceAddress addr, uint8_t offset, uint32_t value) {
+    out32(PCI_CONFIG_ADDRESS_PIO, pci_config_address(addr, offset));
+    out32(PCI_CONFIG_DATA_PIO, value);
+}
+
+static bool pci_is_class_match(struct PCIDeviceAddress addr, uint8_t class_code, uint8_t subclass) {
+    uint32_t class_register = pci_config_read(addr, PCI_OFFSET_CLASS);
+    return (uint8_t) (class_register >> 24) == class_code && (uint8_t) (class_register >> 16) == subclass;
+}
+
+bool pci_find_device_by_class(uint8_t class_code, uint8_t subclass, struct PCIDeviceAddress *result) {
+    for (uint32_t bus = 0; bus < PCI_BUS_COUNT; bus++) {
+        for (uint8_t device = 0; device < PCI_DEVICE_COUNT; device++) {
+            struct PCIDeviceAddress addr = {.bus = bus, .device = device, .function = 0};
+            if ((pci_config_read(addr, PCI_OFFSET_VENDOR_ID) & 0xFFFF) == PCI_VENDOR_ID_INVALID)
+                continue;
+
+            // Only check other functions if device is multi-function device
+            bool    is_multi_function = (pci_config_read(addr, PCI_OFFSET_HEADER_TYPE) >> 16) & PCI_HEADER_TYPE_MULTI_FUNCTION;
+            uint8_t function_count    = is_multi_function ? PCI_FUNCTION_COUNT : 1;
+            for (uint8_t function = 0; function < function_count; function++) {
+                addr.function = function;
+                if ((pci_config_read(addr, PCI_OFFSET_VENDOR_ID) & 0xFFFF) == PCI_VENDOR_ID_INVALID)
+                    continue;
+                if (pci_is_class_match(addr, class_code, subclass)) {
+                    *result = addr;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
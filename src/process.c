@@ -1,95 +1,188 @@
 #include "header/process/process.h"
+#include "header/process/scheduler.h"
 #include "header/memory/paging.h"
 #include "header/stdlib/string.h"
 #include "header/cpu/gdt.h"
 #include "header/kernel-entrypoint.h"
+#include "header/filesystem/file.h"
+#include "header/memory/slab.h"
+#include "header/memory/frame-allocator.h"
+#include "header/filesystem/image-cache.h"
 
-struct ProcessControlBlock _process_list[PROCESS_COUNT_MAX] = {
-    [0 ... PROCESS_COUNT_MAX-1] = { .metadata.state = PROCESS_STOPPED }
-};
+struct ProcessControlBlock **_process_list         = NULL;
+uint32_t                   _process_list_capacity = 0;
 
+/**
+ * Process manager states
+ *
+ * @param active_process_count Process count that is not stopped
+ * @param available_pid        Next PID candidate
+ * @param pcb_cache            Slab cache of ProcessControlBlock, created on first process creation
+ * @param unused_slot          _process_list[unused_slot ... capacity-1] is NULL
+ * @param free_pcb             Stopped PCB list for reuse, linked through scheduler.queue_next
+ * @param pid_bucket           PID hash bucket of every process that is not stopped, linked through metadata.pid_next
+ */
 static struct {
-    uint32_t active_process_count;
-    uint32_t available_pid;
+    uint32_t                   active_process_count;
+    uint32_t                   available_pid;
+    struct SlabCache           *pcb_cache;
+    uint32_t                   unused_slot;
+    struct ProcessControlBlock *free_pcb;
+    struct ProcessControlBlock *pid_bucket[PROCESS_PID_HASH_BUCKET_COUNT];
 } process_manager_state = {
     .active_process_count = 0,
     .available_pid        = 0,
+    .pcb_cache            = NULL,
+    .unused_slot          = 0,
+    .free_pcb             = NULL,
 };
 
 static inline int32_t ceil_div(int32_t a, int32_t b) {
     return a / b + (a % b != 0);
 }
 
-static uint32_t process_generate_new_pid() {
-    return process_manager_state.available_pid++;
+static struct ProcessControlBlock** process_pid_bucket(uint32_t pid) {
+    return &process_manager_state.pid_bucket[pid % PROCESS_PID_HASH_BUCKET_COUNT];
 }
 
-static int32_t process_list_get_inactive_index() {
-    if (process_manager_state.active_process_count >= PROCESS_COUNT_MAX)
-        return -1;
-    for (uint32_t i = 0; i < PROCESS_COUNT_MAX; ++i)
-        if (_process_list[i].metadata.state == PROCESS_STOPPED)
-            return i;
-    return -1;
+// Assign new PID and index the process, PID of live process is skipped after wrap around
+static void process_assign_new_pid(struct ProcessControlBlock *pcb) {
+    while (process_get_pcb_by_pid(process_manager_state.available_pid) != NULL)
+        process_manager_state.available_pid++;
+    pcb->metadata.pid = process_manager_state.available_pid++;
+
+    struct ProcessControlBlock **bucket = process_pid_bucket(pcb->metadata.pid);
+    pcb->metadata.pid_next = *bucket;
+    *bucket                = pcb;
+}
+
+// Slab constructor, free PCB is kept in stopped state
+static void process_pcb_constructor(void *object) {
+    memset(object, 0, sizeof(struct ProcessControlBlock));
+    ((struct ProcessControlBlock*) object)->metadata.state = PROCESS_STOPPED;
+}
+
+// Double process table capacity, new slot is NULL
+static bool process_list_grow(void) {
+    uint32_t                   new_capacity = _process_list_capacity == 0 ? PROCESS_LIST_INITIAL_CAPACITY : 2*_process_list_capacity;
+    struct ProcessControlBlock **new_list   = kmalloc(new_capacity * sizeof(struct ProcessControlBlock*));
+    if (new_list == NULL)
+        return false;
+    memset(new_list, 0, new_capacity * sizeof(struct ProcessControlBlock*));
+    if (_process_list != NULL)
+        memcpy(new_list, _process_list, _process_list_capacity * sizeof(struct ProcessControlBlock*));
+
+    // Scheduler may read table from timer interrupt, swap table before freeing old one
+    struct ProcessControlBlock **old_list = _process_list;
+    _process_list          = new_list;
+    _process_list_capacity = new_capacity;
+    kfree(old_list);
+    return true;
+}
+
+/**
+ * Get stopped PCB from free list, otherwise allocate PCB into unused slot and grow process table if needed
+ *
+ * @return PCB in stopped state, NULL if out of memory
+ */
+static struct ProcessControlBlock* process_list_get_inactive_pcb(void) {
+    struct ProcessControlBlock *pcb = process_manager_state.free_pcb;
+    if (pcb != NULL) {
+        process_manager_state.free_pcb = pcb->scheduler.queue_next;
+        return pcb;
+    }
+
+    if (process_manager_state.pcb_cache == NULL)
+        process_manager_state.pcb_cache = slab_cache_create(
+            "pcb", sizeof(struct ProcessControlBlock), 0, process_pcb_constructor
+        );
+    if (process_manager_state.pcb_cache == NULL)
+        return NULL;
+    if (process_manager_state.unused_slot == _process_list_capacity && !process_list_grow())
+        return NULL;
+    if ((pcb = slab_cache_alloc(process_manager_state.pcb_cache)) == NULL)
+        return NULL;
+    _process_list[process_manager_state.unused_slot++] = pcb;
+    return pcb;
+}
+
+// Stop PCB and put it into free list
+static void process_list_release_pcb(struct ProcessControlBlock *pcb) {
+    pcb->metadata.state            = PROCESS_STOPPED;
+    pcb->scheduler.queue_next      = process_manager_state.free_pcb;
+    process_manager_state.free_pcb = pcb;
 }
 
 struct ProcessControlBlock* process_get_current_running_pcb_pointer(void) {
-    for (uint32_t i = 0; i < PROCESS_COUNT_MAX; ++i)
-        if (_process_list[i].metadata.state == PROCESS_RUNNING)
-            return &_process_list[i];
-    return NULL;
+    return scheduler_get_running_process();
+}
+
+struct ProcessControlBlock* process_get_pcb_by_pid(uint32_t pid) {
+    struct ProcessControlBlock *pcb = *process_pid_bucket(pid);
+    while (pcb != NULL && pcb->metadata.pid != pid)
+        pcb = pcb->metadata.pid_next;
+    return pcb;
 }
 
 int32_t process_create_user_process(struct FAT32DriverRequest request) {
     int32_t retcode = PROCESS_CREATE_SUCCESS; 
-    if (process_manager_state.active_process_count >= PROCESS_COUNT_MAX) {
-        retcode = PROCESS_CREATE_FAIL_MAX_PROCESS_EXCEEDED;
+    // Ensure entrypoint is not located at kernel's section at higher half
+    if ((uint32_t) request.buf >= _linker_kernel_virtual_base) {
+        retcode = PROCESS_CREATE_FAIL_ENTRYPOINT_INVALID;
         goto exit_cleanup;
     }
 
-    // Ensure entrypoint is not located at kernel's section at higher half
-    if ((uint32_t) request.buf >= _linker_kernel_virtual_base) {
+    // Image range must not overlap user stack region
+    void *top_user_esp = (void*) ((uint32_t) &_linker_kernel_virtual_base - sizeof(int));
+    if ((uint32_t) request.buf >= PROCESS_USER_STACK_BASE || request.buffer_size > PROCESS_USER_STACK_BASE - (uint32_t) request.buf) {
         retcode = PROCESS_CREATE_FAIL_ENTRYPOINT_INVALID;
         goto exit_cleanup;
     }
 
-    // Check whether memory is enough for the executable and additional frame for user stack
-    uint32_t page_frame_count_needed = ceil_div(request.buffer_size + PAGE_FRAME_SIZE, PAGE_FRAME_SIZE);
-    if (!paging_allocate_check(page_frame_count_needed) || page_frame_count_needed > PROCESS_PAGE_FRAME_COUNT_MAX) {
+    // Image & stack frames are allocated on demand, only check the resident size limit
+    uint32_t page_frame_count_max = ceil_div(request.buffer_size, PAGE_FRAME_SIZE) + 1 + PROCESS_USER_STACK_SIZE / PAGE_FRAME_SIZE;
+    if (!paging_allocate_check(1) || page_frame_count_max > PROCESS_PAGE_FRAME_COUNT_MAX) {
         retcode = PROCESS_CREATE_FAIL_NOT_ENOUGH_MEMORY;
         goto exit_cleanup;
     }
 
-    // Process PCB 
-    int32_t p_index = process_list_get_inactive_index();
-    struct ProcessControlBlock *new_pcb = &(_process_list[p_index]);
-
-    // Create new page directory for the process. Allocate frame needed for exec + stack
-    struct PageDirectory *new_page_dir = paging_create_new_page_directory();
-    void                 *top_user_esp = (void*) ((uint32_t) &_linker_kernel_virtual_base - sizeof(int));
-    new_pcb->context.page_directory_virtual_addr  = new_page_dir;
-    new_pcb->memory.page_frame_used_count = page_frame_count_needed;
-    for (uint32_t i = 0; i < page_frame_count_needed - 1; ++i) {
-        void *virtual_addr = (void *) ((uint32_t) request.buf + i * PAGE_FRAME_SIZE);
-        new_pcb->memory.virtual_addr_used[i] = virtual_addr;
-        paging_allocate_user_page_frame(new_page_dir, virtual_addr);
-    } 
-    paging_allocate_user_page_frame(new_page_dir, top_user_esp);
-    new_pcb->memory.virtual_addr_used[page_frame_count_needed-1] = top_user_esp;
-
-    // Read the executable to memory
-    struct PageDirectory *current_page_dir = paging_get_current_page_directory_addr();
-    paging_use_page_directory(new_page_dir);
-    int read_status = read(request);
-    paging_use_page_directory(current_page_dir);
-
-    // Read failure will cancel the process creation
-    if (read_status != 0) {
-        paging_free_page_directory(new_page_dir);
+    // Only check executable existence & size, content is read on page fault
+    int32_t fd = file_open(request, FILE_MODE_READ, process_manager_state.available_pid);
+    if (fd < 0) {
+        retcode = PROCESS_CREATE_FAIL_FS_READ_FAILURE;
+        goto exit_cleanup;
+    }
+    uint32_t filesize      = file_seek(fd, 0, FILE_SEEK_END);
+    uint32_t first_cluster = file_get_first_cluster(fd);
+    file_close(fd);
+    if (filesize > request.buffer_size) {
         retcode = PROCESS_CREATE_FAIL_FS_READ_FAILURE;
         goto exit_cleanup;
     }
 
+    // Process PCB & page directory, table grow until kernel heap is exhausted
+    struct ProcessControlBlock *new_pcb     = process_list_get_inactive_pcb();
+    struct PageDirectory       *new_page_dir = new_pcb != NULL ? paging_create_new_page_directory() : NULL;
+    if (new_page_dir == NULL) {
+        if (new_pcb != NULL)
+            process_list_release_pcb(new_pcb);
+        retcode = PROCESS_CREATE_FAIL_MAX_PROCESS_EXCEEDED;
+        goto exit_cleanup;
+    }
+    new_pcb->image = (struct ProcessImage) {
+        .parent_cluster = request.parent_cluster_number,
+        .base           = request.buf,
+        .size           = request.buffer_size,
+        .filesize       = filesize,
+        .first_cluster  = first_cluster,
+    };
+    memcpy(new_pcb->image.name, request.name, 8);
+    memcpy(new_pcb->image.ext, request.ext, 3);
+
+    // Image & stack range of new page directory is left not-present
+    new_pcb->context.page_directory_virtual_addr = new_page_dir;
+    new_pcb->memory.page_frame_used_count        = 0;
+
     // Context creation
     const uint32_t segment_data_register_value = GDT_USER_DATA_SEGMENT_SELECTOR | 0x3;
     struct Context initial_context = {
@@ -123,23 +216,186 @@ int32_t process_create_user_process(struct FAT32DriverRequest request) {
 
     // Process creation success, set the PCB metadata
     process_manager_state.active_process_count++;
-    new_pcb->metadata.pid = process_generate_new_pid();
+    process_assign_new_pid(new_pcb);
     memcpy(new_pcb->metadata.name, request.name, 8);
-    new_pcb->metadata.state = PROCESS_WAITING;
+    new_pcb->scheduler.nice = 0;
+    scheduler_add_process(new_pcb);
 
 exit_cleanup:
     return retcode;
 }
 
-bool process_destroy(uint32_t pid) {
-    for (uint32_t i = 0; i < PROCESS_COUNT_MAX; ++i) {
-        if (_process_list[i].metadata.pid == pid) {
-            // TODO: Release paging & PCB
-            // TODO: SIGTERM + syscall_exit()
-            process_manager_state.available_pid--;
-            process_manager_state.active_process_count--;
-            return true;
-        }
+/**
+ * Read file-backed page of image into new zeroed frame through direct map, then publish it into image cache.
+ * Cache is skipped if executable was replaced since process creation
+ * 
+ * @return Physical address holding single reference for caller, FRAME_ALLOCATE_FAIL on failure
+ */
+static uint32_t process_read_image_page(struct ProcessControlBlock *pcb, uint32_t page_start, uint32_t load_start, uint32_t load_end) {
+    struct ProcessImage *image        = &pcb->image;
+    uint32_t            physical_addr = frame_allocate(0);
+    if (physical_addr == FRAME_ALLOCATE_FAIL && image_cache_shrink() > 0)
+        physical_addr = frame_allocate(0);
+    if (physical_addr == FRAME_ALLOCATE_FAIL)
+        return FRAME_ALLOCATE_FAIL;
+    uint8_t *frame = PAGING_DIRECT_MAP(physical_addr);
+    memset(frame, 0, PAGE_FRAME_SIZE);
+
+    struct FAT32DriverRequest request = {
+        .parent_cluster_number = image->parent_cluster,
+    };
+    memcpy(request.name, image->name, 8);
+    memcpy(request.ext, image->ext, 3);
+    int32_t fd = file_open(request, FILE_MODE_READ, pcb->metadata.pid);
+    if (fd < 0) {
+        frame_free(physical_addr, 0);
+        return FRAME_ALLOCATE_FAIL;
+    }
+    file_seek(fd, load_start - (uint32_t) image->base, FILE_SEEK_SET);
+    int32_t read_size = file_read(fd, frame + (load_start - page_start), load_end - load_start);
+    bool    same_file = file_get_first_cluster(fd) == image->first_cluster;
+    file_close(fd);
+    if (read_size != (int32_t) (load_end - load_start)) {
+        frame_free(physical_addr, 0);
+        return FRAME_ALLOCATE_FAIL;
+    }
+
+    if (same_file)
+        image_cache_insert(image->first_cluster, page_start - (uint32_t) image->base, physical_addr);
+    return physical_addr;
+}
+
+/**
+ * Map page frame at page_addr for process. Page containing executable content is shared
+ * copy-on-write through image cache, other page inside image or stack region is private zero-filled page
+ * 
+ * @return False if page_addr is outside both range or frame cannot be allocated
+ */
+static bool process_load_page(struct ProcessControlBlock *pcb, void *page_addr) {
+    struct ProcessImage  *image      = &pcb->image;
+    struct PageDirectory *page_dir   = pcb->context.page_directory_virtual_addr;
+    uint32_t             image_addr  = (uint32_t) image->base;
+    uint32_t             image_end   = image_addr + image->size;
+    uint32_t             page_start  = (uint32_t) page_addr;
+    uint32_t             page_end    = page_start + PAGE_FRAME_SIZE;
+    bool                 is_image    = image->size > 0 && page_start < image_end && page_end > image_addr;
+    bool                 is_stack    = page_start >= PROCESS_USER_STACK_BASE && page_start < (uint32_t) &_linker_kernel_virtual_base;
+    if (!is_image && !is_stack)
+        return false;
+    if (pcb->memory.page_frame_used_count >= PROCESS_PAGE_FRAME_COUNT_MAX)
+        return false;
+
+    // Page may start before image base or end past image range, only load the intersection with file content
+    uint32_t load_start = page_start > image_addr ? page_start : image_addr;
+    uint32_t load_end   = page_end < image_addr + image->filesize ? page_end : image_addr + image->filesize;
+    if (!is_image || load_start >= load_end) {
+        if (!paging_allocate_user_page_frame(page_dir, page_addr)
+                && !(image_cache_shrink() > 0 && paging_allocate_user_page_frame(page_dir, page_addr)))
+            return false;
+        pcb->memory.page_frame_used_count++;
+        return true;
+    }
+
+    uint32_t physical_addr = image_cache_lookup(image->first_cluster, page_start - image_addr);
+    if (physical_addr == IMAGE_CACHE_MISS)
+        physical_addr = process_read_image_page(pcb, page_start, load_start, load_end);
+    if (physical_addr == FRAME_ALLOCATE_FAIL)
+        return false;
+
+    // Mapping hold its own reference, drop the one from lookup / allocation
+    bool is_mapped = paging_map_shared_user_page_frame(page_dir, page_addr, physical_addr);
+    frame_free(physical_addr, 0);
+    if (is_mapped)
+        pcb->memory.page_frame_used_count++;
+    return is_mapped;
+}
+
+bool process_handle_page_fault(void *fault_addr, uint32_t error_code) {
+    struct ProcessControlBlock *pcb = process_get_current_running_pcb_pointer();
+    if (pcb == NULL)
+        return false;
+
+    // Protection fault is only serviceable as write into copy-on-write user page, either from user or syscall
+    void *page_addr = (void*) ((uint32_t) fault_addr & ~(PAGE_FRAME_SIZE - 1));
+    if (error_code & PAGE_FAULT_ERROR_PRESENT)
+        return (error_code & PAGE_FAULT_ERROR_WRITE) && (uint32_t) fault_addr < (uint32_t) &_linker_kernel_virtual_base
+            && paging_resolve_copy_on_write(pcb->context.page_directory_virtual_addr, page_addr);
+    return process_load_page(pcb, page_addr);
+}
+
+bool process_prefault_user_range(const void *addr, uint32_t size, bool write) {
+    struct ProcessControlBlock *pcb = process_get_current_running_pcb_pointer();
+    uint32_t                   end  = (uint32_t) addr + size;
+    if (pcb == NULL || end < (uint32_t) addr || end > (uint32_t) &_linker_kernel_virtual_base)
+        return false;
+
+    // Destination page is made private before disk DMA write it behind MMU back
+    struct PageDirectory *page_dir = pcb->context.page_directory_virtual_addr;
+    uint32_t             physical_addr;
+    for (uint32_t page = (uint32_t) addr & ~(PAGE_FRAME_SIZE - 1); page < end; page += PAGE_FRAME_SIZE) {
+        if (!paging_virtual_to_physical_addr(page_dir, (void*) page, &physical_addr)
+                && !process_load_page(pcb, (void*) page))
+            return false;
+        if (write && !paging_virtual_to_writable_physical_addr(page_dir, (void*) page, &physical_addr)
+                && !paging_resolve_copy_on_write(page_dir, (void*) page))
+            return false;
+    }
+    return true;
+}
+
+int32_t process_fork(struct Context context) {
+    struct ProcessControlBlock *parent_pcb = process_get_current_running_pcb_pointer();
+    if (parent_pcb == NULL)
+        return -1;
+
+    // Growing process table does not move PCB, parent_pcb stay valid
+    struct ProcessControlBlock *new_pcb = process_list_get_inactive_pcb();
+    if (new_pcb == NULL)
+        return -1;
+    struct PageDirectory *new_page_dir = fpu_fork(parent_pcb, new_pcb)
+        ? paging_fork_page_directory(parent_pcb->context.page_directory_virtual_addr) : NULL;
+    if (new_page_dir == NULL) {
+        fpu_release(new_pcb);
+        process_list_release_pcb(new_pcb);
+        return -1;
     }
-    return false;
-}
\ No newline at end of file
+    new_pcb->image   = parent_pcb->image;
+    new_pcb->memory  = parent_pcb->memory;
+    new_pcb->context = context;
+    new_pcb->context.cpu.general.eax              = 0;
+    new_pcb->context.page_directory_virtual_addr = new_page_dir;
+
+    process_manager_state.active_process_count++;
+    process_assign_new_pid(new_pcb);
+    memcpy(new_pcb->metadata.name, parent_pcb->metadata.name, PROCESS_NAME_LENGTH_MAX);
+    new_pcb->scheduler.nice = parent_pcb->scheduler.nice;
+    scheduler_add_process(new_pcb);
+    return new_pcb->metadata.pid;
+}
+
+bool process_destroy(uint32_t pid) {
+    struct ProcessControlBlock **link = process_pid_bucket(pid);
+    while (*link != NULL && (*link)->metadata.pid != pid)
+        link = &(*link)->metadata.pid_next;
+    struct ProcessControlBlock *pcb = *link;
+    if (pcb == NULL)
+        return false;
+    *link = pcb->metadata.pid_next;
+    scheduler_remove_process(pcb);
+
+    // Destroyed address space may be the active one, kernel half stay mapped in kernel page directory
+    struct PageDirectory *page_dir = pcb->context.page_directory_virtual_addr;
+    if (paging_get_current_page_directory_addr() == page_dir)
+        paging_use_page_directory(&_paging_kernel_page_directory);
+    paging_free_page_directory(page_dir);
+    pcb->context.page_directory_virtual_addr = NULL;
+    pcb->memory.page_frame_used_count        = 0;
+
+    fpu_release(pcb);
+    file_close_all(pid);
+    scheduler_wake_up(&pcb->scheduler.exit_wait_queue);
+    // Running process keep its stopped PCB until caller switch into next process
+    process_list_release_pcb(pcb);
+    process_manager_state.active_process_count--;
+    return true;
+}
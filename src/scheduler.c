@@ -1,41 +1,282 @@
 #include "header/process/process.h"
 #include "header/process/scheduler.h"
 #include "header/cpu/interrupt.h"
+#include "header/cpu/fpu.h"
 #include "header/memory/paging.h"
 
+/**
+ * Scheduler states. Every waiting process is in run queue of its priority
+ * 
+ * @param run_queue         Run queue of every priority
+ * @param nonempty_priority Bit p set if run queue p is not empty, highest priority is found with bsf
+ * @param boost_tick        Timer tick since last priority boost, including kernel & idle time
+ * @param clock_tick        Timer tick since boot, wrap around
+ * @param sleep_queue       Sleeping process sorted by wake_tick
+ * @param running           Last process switched into, only valid while its state is still PROCESS_RUNNING
+ */
 static struct {
-    uint32_t process_idx;
+    struct ProcessQueue        run_queue[SCHEDULER_PRIORITY_COUNT];
+    uint32_t                   nonempty_priority;
+    uint32_t                   boost_tick;
+    uint32_t                   clock_tick;
+    struct ProcessQueue        sleep_queue;
+    struct ProcessControlBlock *running;
 } scheduler_state = {
-    .process_idx = 0,
+    .nonempty_priority = 0,
+    .boost_tick        = 0,
+    .clock_tick        = 0,
+    .running           = NULL,
 };
 
+
+
+// -- Internal helper --
+static uint32_t scheduler_quantum(uint8_t priority) {
+    return SCHEDULER_QUANTUM_BASE_TICK << priority;
+}
+
+// Insert pcb before next, or at tail if next is NULL
+static void process_queue_insert(struct ProcessQueue *queue, struct ProcessControlBlock *pcb, struct ProcessControlBlock *next) {
+    struct ProcessControlBlock *prev = next != NULL ? next->scheduler.queue_prev : queue->tail;
+    pcb->scheduler.queue_next = next;
+    pcb->scheduler.queue_prev = prev;
+    if (prev != NULL)
+        prev->scheduler.queue_next = pcb;
+    else
+        queue->head = pcb;
+    if (next != NULL)
+        next->scheduler.queue_prev = pcb;
+    else
+        queue->tail = pcb;
+}
+
+static void process_queue_remove(struct ProcessQueue *queue, struct ProcessControlBlock *pcb) {
+    if (pcb->scheduler.queue_prev != NULL)
+        pcb->scheduler.queue_prev->scheduler.queue_next = pcb->scheduler.queue_next;
+    else
+        queue->head = pcb->scheduler.queue_next;
+    if (pcb->scheduler.queue_next != NULL)
+        pcb->scheduler.queue_next->scheduler.queue_prev = pcb->scheduler.queue_prev;
+    else
+        queue->tail = pcb->scheduler.queue_prev;
+}
+
+static void scheduler_queue_push(struct ProcessControlBlock *pcb) {
+    process_queue_insert(&scheduler_state.run_queue[pcb->scheduler.priority], pcb, NULL);
+    scheduler_state.nonempty_priority |= 1u << pcb->scheduler.priority;
+}
+
+static void scheduler_queue_remove(struct ProcessControlBlock *pcb) {
+    struct ProcessQueue *queue = &scheduler_state.run_queue[pcb->scheduler.priority];
+    process_queue_remove(queue, pcb);
+    if (queue->head == NULL)
+        scheduler_state.nonempty_priority &= ~(1u << pcb->scheduler.priority);
+}
+
+// Blocked process become runnable, priority & remaining quantum is kept
+static void scheduler_make_runnable(struct ProcessControlBlock *pcb) {
+    process_queue_remove(pcb->scheduler.wait_queue, pcb);
+    pcb->scheduler.wait_queue = NULL;
+    pcb->metadata.state       = PROCESS_WAITING;
+    scheduler_queue_push(pcb);
+}
+
+// Move every process into its base priority with full quantum
+static void scheduler_boost_all(void) {
+    for (uint8_t priority = 1; priority < SCHEDULER_PRIORITY_COUNT; priority++) {
+        struct ProcessControlBlock *pcb = scheduler_state.run_queue[priority].head;
+        while (pcb != NULL) {
+            struct ProcessControlBlock *next = pcb->scheduler.queue_next;
+            if (pcb->scheduler.nice < priority) {
+                scheduler_queue_remove(pcb);
+                pcb->scheduler.priority  = pcb->scheduler.nice;
+                pcb->scheduler.tick_left = scheduler_quantum(pcb->scheduler.nice);
+                scheduler_queue_push(pcb);
+            }
+            pcb = next;
+        }
+    }
+    scheduler_boost_current_process();
+}
+
+
+
+// -- Public interfaces --
 void scheduler_init(void) {
     activate_timer_interrupt();
 }
 
+struct ProcessControlBlock* scheduler_get_running_process(void) {
+    struct ProcessControlBlock *running_pcb = scheduler_state.running;
+    if (running_pcb == NULL || running_pcb->metadata.state != PROCESS_RUNNING)
+        return NULL;
+    return running_pcb;
+}
+
 void scheduler_save_context_to_current_running_pcb(struct Context ctx) {
     struct ProcessControlBlock *running_pcb = process_get_current_running_pcb_pointer();
     running_pcb->context = ctx;
 }
 
+void scheduler_add_process(struct ProcessControlBlock *pcb) {
+    pcb->metadata.state      = PROCESS_WAITING;
+    pcb->scheduler.priority  = pcb->scheduler.nice;
+    pcb->scheduler.tick_left = scheduler_quantum(pcb->scheduler.nice);
+    scheduler_queue_push(pcb);
+    timer_arm_next_event();
+}
+
+void scheduler_remove_process(struct ProcessControlBlock *pcb) {
+    if (pcb->metadata.state == PROCESS_WAITING)
+        scheduler_queue_remove(pcb);
+    else if (pcb->metadata.state == PROCESS_BLOCKED)
+        process_queue_remove(pcb->scheduler.wait_queue, pcb);
+}
+
+void scheduler_clock_tick(uint32_t tick) {
+    scheduler_state.clock_tick += tick;
+    scheduler_state.boost_tick += tick;
+    if (scheduler_state.boost_tick >= SCHEDULER_BOOST_INTERVAL) {
+        scheduler_state.boost_tick = 0;
+        scheduler_boost_all();
+    }
+
+    struct ProcessControlBlock *pcb;
+    while ((pcb = scheduler_state.sleep_queue.head) != NULL && (int32_t) (scheduler_state.clock_tick - pcb->scheduler.wake_tick) >= 0)
+        scheduler_make_runnable(pcb);
+}
+
+bool scheduler_tick(uint32_t tick) {
+    struct ProcessControlBlock *running_pcb = process_get_current_running_pcb_pointer();
+    if (running_pcb == NULL)
+        return false;
+    if (tick >= running_pcb->scheduler.tick_left) {
+        // Whole quantum used, CPU-bound process sink into lower priority
+        if (running_pcb->scheduler.priority < SCHEDULER_PRIORITY_COUNT - 1)
+            running_pcb->scheduler.priority++;
+        running_pcb->scheduler.tick_left = scheduler_quantum(running_pcb->scheduler.priority);
+        return true;
+    }
+    running_pcb->scheduler.tick_left -= tick;
+
+    // Higher priority process is waiting, remaining quantum is kept
+    return (scheduler_state.nonempty_priority & ((1u << running_pcb->scheduler.priority) - 1)) != 0;
+}
+
+uint32_t scheduler_next_event_tick(void) {
+    uint32_t next_tick = SCHEDULER_NO_EVENT;
+    struct ProcessControlBlock *sleeping_pcb = scheduler_state.sleep_queue.head;
+    if (sleeping_pcb != NULL) {
+        int32_t wait_tick = (int32_t) (sleeping_pcb->scheduler.wake_tick - scheduler_state.clock_tick);
+        next_tick = wait_tick > 0 ? (uint32_t) wait_tick : 0;
+    }
+
+    // Quantum & boost only decide between process waiting for CPU
+    if (scheduler_state.nonempty_priority == 0)
+        return next_tick;
+    if (SCHEDULER_BOOST_INTERVAL - scheduler_state.boost_tick < next_tick)
+        next_tick = SCHEDULER_BOOST_INTERVAL - scheduler_state.boost_tick;
+    struct ProcessControlBlock *running_pcb = scheduler_get_running_process();
+    if (running_pcb == NULL)
+        return next_tick;
+    if (scheduler_state.nonempty_priority & ((1u << running_pcb->scheduler.priority) - 1))
+        return 0;
+    return running_pcb->scheduler.tick_left < next_tick ? running_pcb->scheduler.tick_left : next_tick;
+}
+
+uint32_t scheduler_get_clock_tick(void) {
+    return scheduler_state.clock_tick;
+}
+
+__attribute__((noreturn)) void scheduler_yield(struct Context ctx) {
+    scheduler_save_context_to_current_running_pcb(ctx);
+    scheduler_switch_to_next_process();
+}
+
+__attribute__((noreturn)) void scheduler_block_current_process(struct ProcessQueue *queue, struct Context ctx) {
+    struct ProcessControlBlock *running_pcb = process_get_current_running_pcb_pointer();
+    running_pcb->context              = ctx;
+    running_pcb->metadata.state       = PROCESS_BLOCKED;
+    running_pcb->scheduler.wait_queue = queue;
+    process_queue_insert(queue, running_pcb, NULL);
+    scheduler_switch_to_next_process();
+}
+
+__attribute__((noreturn)) void scheduler_sleep_current_process(uint32_t tick, struct Context ctx) {
+    struct ProcessControlBlock *running_pcb = process_get_current_running_pcb_pointer();
+    running_pcb->context              = ctx;
+    running_pcb->metadata.state       = PROCESS_BLOCKED;
+    running_pcb->scheduler.wait_queue = &scheduler_state.sleep_queue;
+    running_pcb->scheduler.wake_tick  = scheduler_state.clock_tick + tick;
+
+    // Keep sleep queue sorted, clock tick only need to check the head
+    struct ProcessControlBlock *next = scheduler_state.sleep_queue.head;
+    while (next != NULL && (int32_t) (next->scheduler.wake_tick - running_pcb->scheduler.wake_tick) <= 0)
+        next = next->scheduler.queue_next;
+    process_queue_insert(&scheduler_state.sleep_queue, running_pcb, next);
+    scheduler_switch_to_next_process();
+}
+
+void scheduler_wake_up(struct ProcessQueue *queue) {
+    while (queue->head != NULL)
+        scheduler_make_runnable(queue->head);
+    timer_arm_next_event();
+}
+
+void scheduler_boost_current_process(void) {
+    struct ProcessControlBlock *running_pcb = process_get_current_running_pcb_pointer();
+    if (running_pcb == NULL)
+        return;
+    running_pcb->scheduler.priority  = running_pcb->scheduler.nice;
+    running_pcb->scheduler.tick_left = scheduler_quantum(running_pcb->scheduler.nice);
+}
+
+int8_t scheduler_set_nice(uint32_t pid, uint8_t nice) {
+    struct ProcessControlBlock *pcb = process_get_pcb_by_pid(pid);
+    if (pcb == NULL)
+        return SCHEDULER_SET_NICE_FAIL_NOT_FOUND;
+    if (nice >= SCHEDULER_PRIORITY_COUNT)
+        return SCHEDULER_SET_NICE_FAIL_INVALID;
+
+    pcb->scheduler.nice = nice;
+    if (pcb->metadata.state == PROCESS_WAITING) {
+        scheduler_queue_remove(pcb);
+        scheduler_add_process(pcb);
+    } else if (pcb->metadata.state == PROCESS_RUNNING) {
+        scheduler_boost_current_process();
+    }
+    return SCHEDULER_SET_NICE_SUCCESS;
+}
+
 __attribute__((noreturn)) void scheduler_switch_to_next_process(void) {
     struct ProcessControlBlock *prev_running_pcb = process_get_current_running_pcb_pointer();
-    struct ProcessControlBlock *next_running_pcb = NULL;
-
-    if (prev_running_pcb != NULL)
+    if (prev_running_pcb != NULL) {
         prev_running_pcb->metadata.state = PROCESS_WAITING;
-
-    while (!next_running_pcb) {
-        struct ProcessControlBlock *iter_pcb = &_process_list[scheduler_state.process_idx];
-        if (iter_pcb->metadata.state == PROCESS_WAITING)
-            next_running_pcb = iter_pcb;
-        // This will set scheduler_state.process_idx as next process when next_running_pcb found
-        scheduler_state.process_idx = (scheduler_state.process_idx + 1) % PROCESS_COUNT_MAX;
+        scheduler_queue_push(prev_running_pcb);
     }
+    scheduler_state.running = NULL;
+    timer_catch_up();
+
+    // Timer IRQ in service would mask every IRQ while halted below, other path reaching here has nothing to acknowledge
+    timer_ack();
+
+    // Nothing runnable, halt until interrupt wake some process. sti only take effect after hlt, no wake up is missed.
+    // Tickless timer only wake idle CPU for sleeping process
+    if (scheduler_state.nonempty_priority == 0)
+        timer_arm_next_event();
+    while (scheduler_state.nonempty_priority == 0)
+        __asm__ volatile("sti; hlt; cli" : /* <Empty> */ : /* <Empty> */ : "memory");
+
+    uint32_t priority;
+    __asm__("bsf %1, %0" : "=r"(priority) : "rm"(scheduler_state.nonempty_priority));
+    struct ProcessControlBlock *next_running_pcb = scheduler_state.run_queue[priority].head;
+    scheduler_queue_remove(next_running_pcb);
 
     next_running_pcb->metadata.state = PROCESS_RUNNING;
+    scheduler_state.running          = next_running_pcb;
+    timer_arm_next_event();
+    fpu_switch_process(next_running_pcb);
     struct Context ctx_to_switch = next_running_pcb->context;
     paging_use_page_directory(ctx_to_switch.page_directory_virtual_addr);
-    pic_ack(IRQ_TIMER);
     process_context_switch(ctx_to_switch);
-}
\ No newline at end of file
+}
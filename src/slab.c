@@ -0,0 +1,249 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/memory/slab.h"
+#include "header/memory/frame-allocator.h"
+#include "header/stdlib/string.h"
+
+// Large kmalloc block content start after header, keeping 16 bytes alignment
+#define SLAB_LARGE_OFFSET ((sizeof(struct SlabHeader) + 15) & ~15)
+
+/**
+ * Slab allocator states
+ *
+ * @param cache              All cache slots
+ * @param size_class         kmalloc cache for every size class, size_class[i] object size is SLAB_SIZE_CLASS_MIN << i
+ * @param initialized        Lazy initialization flag
+ * @param requested_bytes    Sum of kmalloc() size
+ * @param allocated_bytes    Sum of reserved size for kmalloc()
+ * @param large_alloc_count  kmalloc() served by frame allocator
+ * @param large_frame_in_use Page frame held by large kmalloc block
+ * @param empty_slab_freed   Empty slab returned into frame allocator
+ */
+static struct {
+    struct SlabCache cache[SLAB_CACHE_COUNT_MAX];
+    struct SlabCache *size_class[SLAB_SIZE_CLASS_COUNT];
+    bool             initialized;
+    uint64_t         requested_bytes;
+    uint64_t         allocated_bytes;
+    uint32_t         large_alloc_count;
+    uint32_t         large_frame_in_use;
+    uint32_t         empty_slab_freed;
+} slab_state = {
+    .initialized = false,
+};
+
+
+
+// -- Internal helper --
+static void slab_initialize(void) {
+    slab_state.initialized = true;
+    for (uint32_t i = 0; i < SLAB_SIZE_CLASS_COUNT; i++) {
+        // Name: "kmalloc-<size>"
+        char     name[SLAB_CACHE_NAME_LENGTH] = "kmalloc-";
+        uint32_t size   = SLAB_SIZE_CLASS_MIN << i;
+        uint32_t length = 8;
+        for (uint32_t digit = 1000; digit > 0; digit /= 10)
+            if (size >= digit || digit == 1)
+                name[length++] = '0' + (size / digit) % 10;
+        slab_state.size_class[i] = slab_cache_create(name, size, SLAB_SIZE_CLASS_MIN, NULL);
+    }
+}
+
+static void slab_list_remove(struct SlabHeader **list, struct SlabHeader *slab) {
+    if (slab->prev != NULL)
+        slab->prev->next = slab->next;
+    else
+        *list = slab->next;
+    if (slab->next != NULL)
+        slab->next->prev = slab->prev;
+}
+
+static void slab_list_push(struct SlabHeader **list, struct SlabHeader *slab) {
+    slab->prev = NULL;
+    slab->next = *list;
+    if (*list != NULL)
+        (*list)->prev = slab;
+    *list = slab;
+}
+
+static void** slab_object_link(struct SlabCache *cache, void *object) {
+    return (void**) ((uint8_t*) object + cache->link_offset);
+}
+
+// Allocate new slab from frame allocator, construct every object and link them into free list
+static struct SlabHeader* slab_create(struct SlabCache *cache) {
+    uint32_t physical_addr = frame_allocate(0);
+    if (physical_addr == FRAME_ALLOCATE_FAIL)
+        return NULL;
+
+    struct SlabHeader *slab = PAGING_DIRECT_MAP(physical_addr);
+    slab->cache       = cache;
+    slab->in_use      = 0;
+    slab->large_order = 0;
+    slab->free_object = NULL;
+    for (int32_t i = cache->slab_capacity - 1; i >= 0; i--) {
+        void *object = (uint8_t*) slab + cache->object_offset + i*cache->object_size;
+        if (cache->constructor != NULL)
+            cache->constructor(object);
+        *slab_object_link(cache, object) = slab->free_object;
+        slab->free_object = object;
+    }
+    cache->statistic.slab_count++;
+    cache->statistic.object_total += cache->slab_capacity;
+    return slab;
+}
+
+static void slab_destroy(struct SlabCache *cache, struct SlabHeader *slab) {
+    cache->statistic.slab_count--;
+    cache->statistic.object_total -= cache->slab_capacity;
+    slab_state.empty_slab_freed++;
+    frame_free(PAGING_DIRECT_MAP_TO_PHYSICAL(slab), 0);
+}
+
+
+
+// -- Public interfaces --
+struct SlabCache* slab_cache_create(const char *name, uint32_t object_size, uint32_t align, void (*constructor)(void *object)) {
+    if (align < SLAB_OBJECT_ALIGN_MIN)
+        align = SLAB_OBJECT_ALIGN_MIN;
+    if (object_size == 0 || object_size > SLAB_SIZE / 2 || (align & (align - 1)) != 0)
+        return NULL;
+
+    struct SlabCache *cache = NULL;
+    for (uint32_t i = 0; i < SLAB_CACHE_COUNT_MAX && cache == NULL; i++)
+        if (!slab_state.cache[i].used)
+            cache = &slab_state.cache[i];
+    if (cache == NULL)
+        return NULL;
+
+    // Free link of constructed object is kept after object content, so free object stay constructed
+    uint32_t content_size = (object_size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    uint32_t link_size    = constructor != NULL ? sizeof(void*) : 0;
+    uint32_t stride       = (content_size + link_size + align - 1) & ~(align - 1);
+    uint32_t first_offset = (sizeof(struct SlabHeader) + align - 1) & ~(align - 1);
+    if (first_offset + stride > SLAB_SIZE)
+        return NULL;
+
+    memset(cache, 0, sizeof(struct SlabCache));
+    cache->used          = true;
+    cache->object_size   = stride;
+    cache->object_offset = first_offset;
+    cache->link_offset   = constructor != NULL ? content_size : 0;
+    cache->slab_capacity = (SLAB_SIZE - first_offset) / stride;
+    cache->constructor   = constructor;
+    cache->statistic.object_size = stride;
+    for (uint32_t i = 0; i < SLAB_CACHE_NAME_LENGTH - 1 && name[i] != '\0'; i++)
+        cache->statistic.name[i] = name[i];
+    return cache;
+}
+
+void* slab_cache_alloc(struct SlabCache *cache) {
+    struct SlabHeader *slab = cache->partial;
+    if (slab == NULL) {
+        slab = cache->empty;
+        if (slab != NULL)
+            slab_list_remove(&cache->empty, slab);
+        else if ((slab = slab_create(cache)) == NULL)
+            return NULL;
+        slab_list_push(&cache->partial, slab);
+    }
+
+    void *object      = slab->free_object;
+    slab->free_object = *slab_object_link(cache, object);
+    slab->in_use++;
+    if (slab->free_object == NULL) {
+        slab_list_remove(&cache->partial, slab);
+        slab_list_push(&cache->full, slab);
+    }
+    cache->statistic.object_in_use++;
+    cache->statistic.alloc_count++;
+    return object;
+}
+
+void slab_cache_free(struct SlabCache *cache, void *object) {
+    struct SlabHeader *slab = (struct SlabHeader*) ((uint32_t) object & ~(SLAB_SIZE - 1));
+    if (slab->free_object == NULL) {
+        slab_list_remove(&cache->full, slab);
+        slab_list_push(&cache->partial, slab);
+    }
+    *slab_object_link(cache, object) = slab->free_object;
+    slab->free_object = object;
+    slab->in_use--;
+    cache->statistic.object_in_use--;
+    cache->statistic.free_count++;
+
+    // Keep single empty slab for reuse, release the rest into frame allocator
+    if (slab->in_use == 0) {
+        slab_list_remove(&cache->partial, slab);
+        if (cache->empty == NULL)
+            slab_list_push(&cache->empty, slab);
+        else
+            slab_destroy(cache, slab);
+    }
+}
+
+void* kmalloc(uint32_t size) {
+    if (!slab_state.initialized)
+        slab_initialize();
+    if (size == 0)
+        return NULL;
+
+    if (size <= SLAB_SIZE_CLASS_MAX) {
+        uint32_t class_index = 0;
+        while ((uint32_t) SLAB_SIZE_CLASS_MIN << class_index < size)
+            class_index++;
+        void *ptr = slab_cache_alloc(slab_state.size_class[class_index]);
+        if (ptr != NULL) {
+            slab_state.requested_bytes += size;
+            slab_state.allocated_bytes += SLAB_SIZE_CLASS_MIN << class_index;
+        }
+        return ptr;
+    }
+
+    // Large block, header share layout with slab so kfree() can tell them apart
+    uint8_t order = 0;
+    while (order < FRAME_ORDER_MAX && ((uint32_t) PAGE_FRAME_SIZE << order) < size + SLAB_LARGE_OFFSET)
+        order++;
+    if (((uint32_t) PAGE_FRAME_SIZE << order) < size + SLAB_LARGE_OFFSET)
+        return NULL;
+    uint32_t physical_addr = frame_allocate(order);
+    if (physical_addr == FRAME_ALLOCATE_FAIL)
+        return NULL;
+
+    struct SlabHeader *header = PAGING_DIRECT_MAP(physical_addr);
+    header->cache       = NULL;
+    header->large_order = order;
+    slab_state.large_alloc_count++;
+    slab_state.large_frame_in_use += 1u << order;
+    slab_state.requested_bytes    += size;
+    slab_state.allocated_bytes    += PAGE_FRAME_SIZE << order;
+    return (uint8_t*) header + SLAB_LARGE_OFFSET;
+}
+
+void kfree(void *ptr) {
+    if (ptr == NULL)
+        return;
+    struct SlabHeader *header = (struct SlabHeader*) ((uint32_t) ptr & ~(SLAB_SIZE - 1));
+    if (header->cache != NULL) {
+        slab_cache_free(header->cache, ptr);
+    } else {
+        slab_state.large_frame_in_use -= 1u << header->large_order;
+        frame_free(PAGING_DIRECT_MAP_TO_PHYSICAL(header), header->large_order);
+    }
+}
+
+struct SlabStatistic slab_get_statistic(void) {
+    struct SlabStatistic statistic = {
+        .requested_bytes    = slab_state.requested_bytes,
+        .allocated_bytes    = slab_state.allocated_bytes,
+        .large_alloc_count  = slab_state.large_alloc_count,
+        .large_frame_in_use = slab_state.large_frame_in_use,
+        .empty_slab_freed   = slab_state.empty_slab_freed,
+        .cache_count        = 0,
+    };
+    for (uint32_t i = 0; i < SLAB_CACHE_COUNT_MAX; i++)
+        if (slab_state.cache[i].used)
+            statistic.cache[statistic.cache_count++] = slab_state.cache[i].statistic;
+    return statistic;
+}
@@ -0,0 +1,60 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "header/stdlib/string-benchmark.h"
+#include "header/stdlib/string.h"
+
+// Destination & source offset from aligned area for every alignment
+static const uint8_t string_benchmark_offset[STRING_BENCHMARK_ALIGN_COUNT][2] = {
+    {0, 0},
+    {1, 1},
+    {3, 0},
+};
+
+static uint64_t rdtsc(void) {
+    uint32_t low, high;
+    __asm__ volatile("rdtsc" : "=a"(low), "=d"(high));
+    return ((uint64_t) high << 32) | low;
+}
+
+// Run single function cell, memcmp() result is accumulated so call is not optimized out
+static uint32_t string_benchmark_cell(uint8_t *buffer, uint8_t function, uint32_t size, uint8_t align) {
+    uint8_t  *dest       = buffer + string_benchmark_offset[align][0];
+    uint8_t  *src        = buffer + STRING_BENCHMARK_SIZE_MAX + 32 + string_benchmark_offset[align][1];
+    uint32_t iteration   = STRING_BENCHMARK_CELL_BYTES / size;
+    volatile int compare = 0;
+
+    uint64_t start = rdtsc();
+    for (uint32_t i = 0; i < iteration; i++) {
+        switch (function) {
+            case 0: memcpy(dest, src, size);  break;
+            case 1: memset(dest, i, size);    break;
+            case 2: compare += memcmp(dest, src, size); break;
+            case 3: memmove(dest + 4, dest, size); break;
+        }
+    }
+    return (uint32_t) (rdtsc() - start);
+}
+
+static void string_benchmark_variant(uint8_t *buffer, uint32_t cycle[STRING_BENCHMARK_FUNCTION_COUNT][STRING_BENCHMARK_SIZE_COUNT][STRING_BENCHMARK_ALIGN_COUNT]) {
+    for (uint8_t function = 0; function < STRING_BENCHMARK_FUNCTION_COUNT; function++) {
+        for (uint8_t size_index = 0; size_index < STRING_BENCHMARK_SIZE_COUNT; size_index++) {
+            for (uint8_t align = 0; align < STRING_BENCHMARK_ALIGN_COUNT; align++) {
+                // memcmp() scan whole area only if both area is equal
+                uint32_t size = STRING_BENCHMARK_SIZE_MIN << (STRING_BENCHMARK_SIZE_SHIFT * size_index);
+                memset(buffer, 0, STRING_BENCHMARK_BUFFER_SIZE);
+                cycle[function][size_index][align] = string_benchmark_cell(buffer, function, size, align);
+            }
+        }
+    }
+}
+
+void string_benchmark_run(uint8_t *buffer, struct StringBenchmarkResult *result) {
+    string_set_sse2(false);
+    string_benchmark_variant(buffer, result->cycle[0]);
+    result->variant_count = 1;
+    if (string_set_sse2(true)) {
+        string_benchmark_variant(buffer, result->cycle[1]);
+        result->variant_count = 2;
+    }
+}
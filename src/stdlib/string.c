@@ -1,26 +1,140 @@
 #include <stdint.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include "header/stdlib/string.h"
 
+// Compiler only need to know xmm is clobbered if it may allocate them itself
+#ifdef __SSE__
+#define STRING_XMM_CLOBBER , "xmm0", "xmm1", "xmm2", "xmm3"
+#else
+#define STRING_XMM_CLOBBER
+#endif
+
+// Machine word that may be unaligned and alias any type, x86 allow unaligned access
+typedef size_t __attribute__((may_alias, aligned(1))) string_word_t;
+
+/**
+ * String states
+ *
+ * @param sse2_available SSE2 path is registered with string_enable_sse2()
+ * @param sse2_enabled   Large memcpy() between mutually misaligned buffer use SSE2 path
+ * @param sse2_active    SSE2 path is running, nested call (e.g. from page fault) use rep string path
+ * @param fpu_begin      Make FPU register usable by kernel, NULL if always usable
+ * @param fpu_end        Give FPU register back, NULL if always usable
+ */
+static struct {
+    bool sse2_available;
+    bool sse2_enabled;
+    bool sse2_active;
+    void (*fpu_begin)(void);
+    void (*fpu_end)(void);
+} string_state = {
+    .sse2_available = false,
+    .sse2_enabled   = false,
+    .sse2_active    = false,
+};
+
+
+
+// -- Internal helper --
+static void rep_movsb(uint8_t **dest, const uint8_t **src, size_t n) {
+    __asm__ volatile("rep movsb" : "+D"(*dest), "+S"(*src), "+c"(n) : /* <Empty> */ : "memory");
+}
+
+static void rep_movsd(uint8_t **dest, const uint8_t **src, size_t n) {
+    __asm__ volatile("rep movsl" : "+D"(*dest), "+S"(*src), "+c"(n) : /* <Empty> */ : "memory");
+}
+
+static void rep_stosb(uint8_t **dest, uint8_t c, size_t n) {
+    __asm__ volatile("rep stosb" : "+D"(*dest), "+c"(n) : "a"(c) : "memory");
+}
+
+static void rep_stosd(uint8_t **dest, uint32_t c, size_t n) {
+    __asm__ volatile("rep stosl" : "+D"(*dest), "+c"(n) : "a"(c) : "memory");
+}
+
+// Whether SSE2 path is usable for n bytes, marking it active
+static bool string_sse2_begin(size_t n) {
+    if (n < STRING_SSE2_THRESHOLD || !string_state.sse2_enabled || string_state.sse2_active)
+        return false;
+    string_state.sse2_active = true;
+    if (string_state.fpu_begin != NULL)
+        string_state.fpu_begin();
+    return true;
+}
+
+static void string_sse2_end(void) {
+    if (string_state.fpu_end != NULL)
+        string_state.fpu_end();
+    string_state.sse2_active = false;
+}
+
+// Copy n / 64 block of 64 bytes, dest must be 16 bytes aligned
+static void memcpy_sse2_block(uint8_t **dest, const uint8_t **src, size_t n) {
+    for (; n >= 64; n -= 64, *dest += 64, *src += 64)
+        __asm__ volatile(
+            "movdqu   (%0), %%xmm0\n"
+            "movdqu 16(%0), %%xmm1\n"
+            "movdqu 32(%0), %%xmm2\n"
+            "movdqu 48(%0), %%xmm3\n"
+            "movdqa %%xmm0,   (%1)\n"
+            "movdqa %%xmm1, 16(%1)\n"
+            "movdqa %%xmm2, 32(%1)\n"
+            "movdqa %%xmm3, 48(%1)\n"
+            : /* <Empty> */
+            : "r"(*src), "r"(*dest)
+            : "memory" STRING_XMM_CLOBBER
+        );
+}
+
+
+
+// -- Public interfaces --
 void* memset(void *s, int c, size_t n) {
-    uint8_t *buf = (uint8_t*) s;
-    for (size_t i = 0; i < n; i++)
-        buf[i] = (uint8_t) c;
+    uint8_t  *buf  = (uint8_t*) s;
+    uint32_t word  = (uint8_t) c * 0x01010101u;
+    if (n >= STRING_WORD_THRESHOLD) {
+        // Align destination, then fill whole word. rep stosd outrun SSE2 store loop at every measured size
+        size_t head = -(uintptr_t) buf & 3;
+        rep_stosb(&buf, c, head);
+        n -= head;
+        rep_stosd(&buf, word, n >> 2);
+        n &= 3;
+    }
+    rep_stosb(&buf, c, n);
     return s;
 }
 
 void* memcpy(void* restrict dest, const void* restrict src, size_t n) {
-    uint8_t *dstbuf       = (uint8_t*) dest;
+    uint8_t       *dstbuf = (uint8_t*) dest;
     const uint8_t *srcbuf = (const uint8_t*) src;
-    for (size_t i = 0; i < n; i++)
-        dstbuf[i] = srcbuf[i];
-    return dstbuf;
+    if (n >= STRING_WORD_THRESHOLD) {
+        // Align destination. Fast rep movsd need source aligned as well, SSE2 unaligned load does not
+        bool   misaligned = ((uintptr_t) dstbuf ^ (uintptr_t) srcbuf) & 3;
+        size_t head       = -(uintptr_t) dstbuf & (misaligned && n >= STRING_SSE2_THRESHOLD ? 15 : 3);
+        rep_movsb(&dstbuf, &srcbuf, head);
+        n -= head;
+        if (misaligned && string_sse2_begin(n)) {
+            memcpy_sse2_block(&dstbuf, &srcbuf, n);
+            string_sse2_end();
+            n &= 63;
+        }
+        rep_movsd(&dstbuf, &srcbuf, n >> 2);
+        n &= 3;
+    }
+    rep_movsb(&dstbuf, &srcbuf, n);
+    return dest;
 }
 
 int memcmp(const void *s1, const void *s2, size_t n) {
     const uint8_t *buf1 = (const uint8_t*) s1;
     const uint8_t *buf2 = (const uint8_t*) s2;
-    for (size_t i = 0; i < n; i++) {
+    // Skip equal word, first different word is resolved bytewise
+    size_t i = 0;
+    for (; i + sizeof(size_t) <= n; i += sizeof(size_t))
+        if (*(const string_word_t*) (buf1 + i) != *(const string_word_t*) (buf2 + i))
+            break;
+    for (; i < n; i++) {
         if (buf1[i] < buf2[i])
             return -1;
         else if (buf1[i] > buf2[i])
@@ -33,13 +147,36 @@ int memcmp(const void *s1, const void *s2, size_t n) {
 void *memmove(void *dest, const void *src, size_t n) {
     uint8_t *dstbuf       = (uint8_t*) dest;
     const uint8_t *srcbuf = (const uint8_t*) src;
+    if (dstbuf + n <= srcbuf || dstbuf >= srcbuf + n)
+        return memcpy(dest, src, n);
+
+    // Overlapping, forward copy is safe if destination start before source
     if (dstbuf < srcbuf) {
-        for (size_t i = 0; i < n; i++)
-            dstbuf[i]   = srcbuf[i];
-    } else {
-        for (size_t i = n; i != 0; i--)
-            dstbuf[i-1] = srcbuf[i-1];
+        rep_movsd(&dstbuf, &srcbuf, n >> 2);
+        rep_movsb(&dstbuf, &srcbuf, n & 3);
+        return dest;
     }
 
+    // Backward, tail bytes first then whole words. Plain loop, std & backward rep string is microcoded and slow
+    while (n & (sizeof(size_t) - 1)) {
+        n--;
+        dstbuf[n] = srcbuf[n];
+    }
+    for (; n > 0; n -= sizeof(size_t))
+        *(string_word_t*) (dstbuf + n - sizeof(size_t)) = *(const string_word_t*) (srcbuf + n - sizeof(size_t));
     return dest;
-}
\ No newline at end of file
+}
+
+void string_enable_sse2(void (*fpu_begin)(void), void (*fpu_end)(void)) {
+    string_state.fpu_begin      = fpu_begin;
+    string_state.fpu_end        = fpu_end;
+    string_state.sse2_available = true;
+    string_state.sse2_enabled   = true;
+}
+
+bool string_set_sse2(bool enable) {
+    if (enable && !string_state.sse2_available)
+        return false;
+    string_state.sse2_enabled = enable;
+    return true;
+}